@@ -0,0 +1,52 @@
+/*
+**  Author: Aniket Biswas (xunicatt)
+**  Github: https://github.com/xunicatt
+**  Description: measures the cost of copying and destroying object refs
+**  File: gc_ref.cc
+*/
+
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <gc.h>
+#include <object.h>
+#include <print>
+#include <string>
+#include <vector>
+
+static constexpr size_t LIVE_OBJECTS = 10000;
+static constexpr size_t ITERATIONS = 10000000;
+
+int
+main(int argc, char* argv[]) {
+  size_t iterations = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : ITERATIONS;
+
+  // a realistic number of live objects, the old map based table got
+  // slower the more objects were alive
+  std::vector<ObjectRef> live;
+  for(size_t i = 0; i < LIVE_OBJECTS; i++) {
+    ObjectRef obj = gc::alloc();
+    obj->type = ObjectType::STRING;
+    obj->child = String(std::to_string(i));
+    live.push_back(obj);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  for(size_t i = 0; i < iterations; i++) {
+    ObjectRef copy = live[i % LIVE_OBJECTS];
+    ObjectRef other = copy;
+    other = live[(i + 1) % LIVE_OBJECTS];
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  double ns = std::chrono::duration<double, std::nano>(end - start).count();
+  // every iteration does two copies, one assignment and two destructions
+  std::println(
+    "gc_ref: {} iterations, {:.2f} ns/iteration",
+    iterations,
+    ns / static_cast<double>(iterations)
+  );
+
+  gc::purge();
+  return 0;
+}
@@ -0,0 +1,72 @@
+/*
+**  Author: Aniket Biswas (xunicatt)
+**  Github: https://github.com/xunicatt
+**  Description: measures lexer throughput over a large generated input
+**  File: lexer.cc
+*/
+
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <lexer.h>
+#include <print>
+#include <string>
+#include <token.h>
+
+static constexpr size_t INPUT_MB = 64;
+
+// a bit of everything the lexer scans: indentation, comments,
+// identifiers, keywords, numbers, operators and string literals
+static const std::string SAMPLE = R"(# computes a few things to keep the lexer busy
+struct Point { x: int, y: int }
+
+func distance_squared(a, b) {
+  let dx = a.x - b.x;
+  let dy = a.y - b.y;
+  return dx * dx + dy * dy;
+}
+
+func describe(points) {
+  let total = 0.0;
+  for(let i = 0; i < len(points); i += 1) {
+    # a comment inside a loop body
+    total += to_float(distance_squared(points[i], Point{x: 0, y: 0}));
+    if(total >= 1000.5) {
+      println('the total is getting large: \'', total, '\'\n');
+    }
+  }
+  return 'a longer string literal that spans quite a few characters';
+}
+)";
+
+int
+main(int argc, char* argv[]) {
+  size_t megabytes = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : INPUT_MB;
+
+  std::string data;
+  data.reserve(megabytes * 1024 * 1024 + SAMPLE.size());
+  while(data.size() < megabytes * 1024 * 1024) {
+    data += SAMPLE;
+  }
+
+  std::string filename = "bench";
+  Lexer lexer(filename, data);
+  size_t tokens = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  while(lexer.next_token() != token::Token::EOF_) {
+    tokens++;
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  double seconds = std::chrono::duration<double>(end - start).count();
+  double mb = static_cast<double>(data.size()) / (1024.0 * 1024.0);
+  std::println(
+    "lexer: {:.1f} MB, {} tokens, {:.1f} MB/s",
+    mb,
+    tokens,
+    mb / seconds
+  );
+
+  return 0;
+}
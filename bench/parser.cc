@@ -0,0 +1,90 @@
+/*
+**  Author: Aniket Biswas (xunicatt)
+**  Github: https://github.com/xunicatt
+**  Description: measures parser throughput on a large generated input and
+**               on many one line inputs the way the repl parses them
+**  File: parser.cc
+*/
+
+#include <ast.h>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <lexer.h>
+#include <parser.h>
+#include <print>
+#include <string>
+
+static constexpr size_t INPUT_MB = 16;
+static constexpr size_t REPL_LINES = 200000;
+
+// expression heavy code so most of the time goes to the pratt loop
+static const std::string SAMPLE = R"(func area(shapes) {
+  let total = 0.0;
+  for(let i = 0; i < len(shapes); i += 1) {
+    let s = shapes[i];
+    if(s.kind == 'circle') {
+      total += 3.14159 * s.r * s.r;
+    } else {
+      total += (s.w + 1) * (s.h - 1) / 2 - -s.d;
+    }
+    total = total * 1.0 + shapes[i].offset[0][1] - f(a, b, c + d * e);
+  }
+  return !(total <= 0.0) == true;
+}
+)";
+
+static const std::string REPL_LINE = "let x = (a + b * c - d / e) >= f(g[1], h.i, [1, 2, 3]);";
+
+int
+main(int argc, char* argv[]) {
+  size_t megabytes = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : INPUT_MB;
+  std::string filename = "bench";
+
+  std::string data;
+  data.reserve(megabytes * 1024 * 1024 + SAMPLE.size());
+  while(data.size() < megabytes * 1024 * 1024) {
+    data += SAMPLE;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  Lexer lexer(filename, data);
+  parser::Parser parser(lexer);
+  ast::ProgramRef prgm = parser.parse();
+  auto end = std::chrono::steady_clock::now();
+
+  if(prgm == nullptr) {
+    std::println(stderr, "parser: sample failed to parse");
+    return 1;
+  }
+
+  double seconds = std::chrono::duration<double>(end - start).count();
+  double mb = static_cast<double>(data.size()) / (1024.0 * 1024.0);
+  std::println(
+    "parser: {:.1f} MB, {} statements, {:.1f} MB/s",
+    mb,
+    prgm->stmts.size(),
+    mb / seconds
+  );
+
+  // a new lexer and parser per line, as the repl does
+  start = std::chrono::steady_clock::now();
+  for(size_t i = 0; i < REPL_LINES; i++) {
+    Lexer line_lexer(filename, REPL_LINE);
+    parser::Parser line_parser(line_lexer);
+    if(line_parser.parse() == nullptr) {
+      std::println(stderr, "parser: repl line failed to parse");
+      return 1;
+    }
+  }
+  end = std::chrono::steady_clock::now();
+
+  seconds = std::chrono::duration<double>(end - start).count();
+  std::println(
+    "parser: {} repl lines, {:.0f} lines/s",
+    REPL_LINES,
+    REPL_LINES / seconds
+  );
+
+  return 0;
+}
@@ -1,6 +1,9 @@
 #include <print>
 #include <repl.h>
 #include <exec.h>
+#include <gc.h>
+#include <cstddef>
+#include <cstdlib>
 #include <string>
 
 int
@@ -11,7 +14,7 @@ main(int argc, char* argv[]) {
   }
 
   if(argv[1] == std::string("--help")) {
-    std::println("usage: eta <filename>.n");
+    std::println("usage: eta [--engine=tree|vm] [--gc-growth=<factor>] [--stats] [--cache] [--jobs=<n>] [--report-tail-calls] [--max-stack=<n>] [-O0|-O1] <filename>.n");
     return 0;
   }
 
@@ -20,5 +23,107 @@ main(int argc, char* argv[]) {
     return 0;
   }
 
-  return exec(argv[1]);
+  Engine engine = Engine::TREE;
+  const char* filename = nullptr;
+  bool stats = false;
+  bool cached = false;
+  optimizer::Level level = optimizer::Level::O1;
+  size_t jobs = 1;
+  bool tails = false;
+  size_t max_stack = 0;
+
+  for(int i = 1; i < argc; i++) {
+    std::string arg(argv[i]);
+
+    if(arg == "--engine=tree") {
+      engine = Engine::TREE;
+      continue;
+    }
+
+    if(arg == "--engine=vm") {
+      engine = Engine::VM;
+      continue;
+    }
+
+    if(arg == "--stats") {
+      stats = true;
+      continue;
+    }
+
+    if(arg == "--cache") {
+      cached = true;
+      continue;
+    }
+
+    if(arg == "--report-tail-calls") {
+      tails = true;
+      continue;
+    }
+
+    if(arg == "-O0") {
+      level = optimizer::Level::O0;
+      continue;
+    }
+
+    if(arg == "-O1") {
+      level = optimizer::Level::O1;
+      continue;
+    }
+
+    if(arg.starts_with("--gc-growth=")) {
+      const char* value = argv[i] + std::string("--gc-growth=").length();
+      char* end = nullptr;
+      double factor = std::strtod(value, &end);
+
+      if(end == value || *end != '\0' || factor <= 1.0) {
+        std::println(stderr, "eta: --gc-growth expects a factor greater than 1");
+        return 1;
+      }
+
+      gc::set_growth(factor);
+      continue;
+    }
+
+    if(arg.starts_with("--jobs=")) {
+      const char* value = argv[i] + std::string("--jobs=").length();
+      char* end = nullptr;
+      unsigned long count = std::strtoul(value, &end, 10);
+
+      if(end == value || *end != '\0' || count < 1) {
+        std::println(stderr, "eta: --jobs expects a thread count of at least 1");
+        return 1;
+      }
+
+      jobs = count;
+      continue;
+    }
+
+    if(arg.starts_with("--max-stack=")) {
+      const char* value = argv[i] + std::string("--max-stack=").length();
+      char* end = nullptr;
+      unsigned long count = std::strtoul(value, &end, 10);
+
+      if(end == value || *end != '\0' || count < 1) {
+        std::println(stderr, "eta: --max-stack expects a call depth of at least 1");
+        return 1;
+      }
+
+      max_stack = count;
+      continue;
+    }
+
+    if(arg.starts_with("--")) {
+      std::println(stderr, "eta: unknown option '{}'", arg);
+      return 1;
+    }
+
+    filename = argv[i];
+  }
+
+  if(filename == nullptr) {
+    repl();
+    return 0;
+  }
+
+  return exec(filename, engine, stats, cached, level, jobs, tails, max_stack);
 }
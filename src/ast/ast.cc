@@ -88,7 +88,7 @@ namespace ast {
 
   static inline std::string
   to_string(const StringLit& sl) {
-    return std::format("{{{}: {}}}", to_string(STRINGLIT), sl.value);
+    return std::format("{{{}: {}}}", to_string(STRINGLIT), *sl.value);
   }
 
   static std::string
@@ -343,6 +343,10 @@ namespace ast {
 #endif
 
 
+bool resolved(const Slot& s) {
+  return s.depth >= 0;
+}
+
 Location location(const Expr& e) {
   return std::visit([](const auto& child) { return child.location; }, e.child);
 }
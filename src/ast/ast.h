@@ -9,7 +9,9 @@
 #ifndef __AST_H__
 #define __AST_H__
 
+#include <cstddef>
 #include <memory>
+#include <new>
 #include <token.h>
 #include <cstdint>
 #include <lexer.h>
@@ -61,15 +63,35 @@ struct Expr;
 struct Identifier;
 struct Program;
 
-using StmtRef = std::unique_ptr<Stmt>;
-using BlockStmtRef = std::unique_ptr<BlockStmt>;
-using ExprRef = std::unique_ptr<Expr>;
-using IdentifierRef = std::unique_ptr<Identifier>;
+// nodes are owned by the arena of the program they were parsed into,
+// refs to them do not own anything
+using StmtRef = Stmt*;
+using BlockStmtRef = BlockStmt*;
+using ExprRef = Expr*;
+using IdentifierRef = Identifier*;
 using ProgramRef = std::unique_ptr<Program>;
 
+// text of a string literal, interned in the program's constant pool and
+// shared with every string made from it until one of them is written to
+using Constant = std::shared_ptr<std::string>;
+
+// where a resolved variable lives: the number of scopes to walk out
+// from the current one and its slot there, unresolved names keep a
+// depth of -1 and are looked up by name
+struct Slot {
+  int32_t depth = -1;
+  uint32_t index = 0;
+};
+
+// variables declared directly inside a scope, in slot order
+struct Layout {
+  std::vector<std::string> names;
+};
+
 struct Identifier {
   Location location;
   std::string value;
+  Slot slot = {};
 };
 
 //====================================================
@@ -95,7 +117,7 @@ struct BoolLit {
 
 struct StringLit {
   Location location;
-  std::string value;
+  Constant value;
 };
 
 struct ArrayLit {
@@ -154,6 +176,10 @@ struct MemberExpr {
   Location location;
   ExprRef left;
   IdentifierRef field;
+  // inline cache filled in by the evaluator, the shape of the struct
+  // last accessed here and the slot field has in it
+  mutable uint64_t shape = 0;
+  mutable uint32_t slot = 0;
 };
 
 using ExprChild = std::variant<
@@ -194,12 +220,16 @@ struct LetStmt {
 
 struct BlockStmt {
   std::vector<StmtRef> stmts;
+  // used when the block opens its own scope (function and loop bodies)
+  Layout layout = {};
 };
 
 struct IfStmt {
   ExprRef condition;
   BlockStmtRef consequence;
   BlockStmtRef alternative;
+  // both branches share one scope
+  Layout layout = {};
 };
 
 struct ForStmt {
@@ -207,6 +237,8 @@ struct ForStmt {
   ExprRef condition;
   ExprRef post;
   BlockStmtRef body;
+  // the header scope holding the variables of pre
+  Layout layout = {};
 };
 
 struct FunctionStmt {
@@ -224,6 +256,9 @@ struct ExternStmt {
 
 struct ReturnStmt {
   ExprRef value;
+  // set by the resolver on `return f(...)` inside f when f declares
+  // nothing but its parameters, the call may reuse the running frame
+  bool tail = false;
 };
 
 struct ExprStmt {
@@ -246,10 +281,70 @@ struct Stmt {
   StmtChild child;
 };
 
+// storage for the nodes of one type, handed out from fixed size chunks
+// so a node never moves once made and all of them are freed together
+template<typename T>
+class Pool {
+public:
+  Pool() = default;
+  Pool(const Pool&) = delete;
+  Pool& operator=(const Pool&) = delete;
+
+  ~Pool() {
+    for(size_t i = 0; i < chunks.size(); i++) {
+      size_t n = i + 1 == chunks.size() ? used : CHUNK_NODES;
+      for(size_t j = 0; j < n; j++) {
+        std::destroy_at(reinterpret_cast<T*>(chunks[i][j].bytes));
+      }
+    }
+  }
+
+  T* make(T&& node) {
+    if(chunks.empty() || used == CHUNK_NODES) {
+      chunks.push_back(std::make_unique<Cell[]>(CHUNK_NODES));
+      used = 0;
+    }
+
+    return new (chunks.back()[used++].bytes) T(std::move(node));
+  }
+
+  size_t size() const {
+    return chunks.empty() ? 0 : (chunks.size() - 1) * CHUNK_NODES + used;
+  }
+
+private:
+  static constexpr size_t CHUNK_NODES = 512;
+
+  struct Cell {
+    alignas(T) unsigned char bytes[sizeof(T)];
+  };
+
+  std::vector<std::unique_ptr<Cell[]>> chunks;
+  size_t used = 0;
+};
+
+struct Arena {
+  Pool<Stmt> stmts;
+  Pool<BlockStmt> blocks;
+  Pool<Expr> exprs;
+  Pool<Identifier> identifiers;
+
+  Stmt* make(Stmt&& node) { return stmts.make(std::move(node)); }
+  BlockStmt* make(BlockStmt&& node) { return blocks.make(std::move(node)); }
+  Expr* make(Expr&& node) { return exprs.make(std::move(node)); }
+  Identifier* make(Identifier&& node) { return identifiers.make(std::move(node)); }
+};
+
 struct Program {
   std::vector<StmtRef> stmts;
+  std::vector<Constant> constants;
+  Arena arena;
+  // pieces of the source parsed on other threads, their arenas hold the
+  // nodes of some of stmts
+  std::vector<std::unique_ptr<Program>> parts;
 };
 
+bool resolved(const Slot&);
 Location location(const Expr& e);
 Location location(const ExprRef& e);
 
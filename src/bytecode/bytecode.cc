@@ -0,0 +1,104 @@
+#include <bytecode.h>
+
+#ifdef BYTECODE_DEBUG_INFO_ENABLE
+#include <format>
+#include <string>
+
+namespace bytecode {
+  static const char * const opstr[__OPCODECOUNT__] = {
+    "HALT",
+    "POP",
+    "CONST",
+    "NULL",
+    "TRUE",
+    "FALSE",
+
+    "GET",
+    "LETCHECK",
+    "LET",
+    "ASSIGNCHECK",
+    "ASSIGN",
+    "OPASSIGN",
+
+    "UNARY",
+    "BINARY",
+    "ARRAY",
+
+    "INDEX",
+    "INDEXCHECK",
+    "INDEXKEY",
+    "INDEXSET",
+
+    "MEMBER",
+    "MEMBERCHECK",
+    "MEMBERSET",
+
+    "STRUCTCHECK",
+    "FIELDCHECK",
+    "FIELDTYPE",
+    "STRUCTLIT",
+
+    "PRECALL",
+    "CALL",
+    "TAILCALL",
+    "RETURN",
+
+    "TRY",
+    "ENDTRY",
+    "JUMP",
+    "JUMPIFNOT",
+
+    "PUSHSCOPE",
+    "POPSCOPE",
+    "POPSCOPES",
+
+    "FUNC",
+    "SET",
+    "STRUCT",
+    "EXTERN",
+    "ERROR",
+  };
+
+  std::string
+  to_string(const Chunk& chunk) {
+    std::string res = std::format("== {} ==\n", chunk.name);
+
+    for(size_t i = 0; i < chunk.code.size(); i++) {
+      const Instr& in = chunk.code[i];
+      res += std::format("{:04} {:<12} {} {}", i, opstr[in.op], in.a, in.b);
+
+      switch(in.op) {
+        case GET:
+        case LETCHECK:
+        case LET:
+        case ASSIGNCHECK:
+        case ASSIGN:
+        case OPASSIGN:
+        case SET:
+          res += std::format("\t; {}", chunk.variables[in.a].value);
+          break;
+
+        case MEMBER:
+        case MEMBERCHECK:
+        case MEMBERSET:
+        case FIELDCHECK:
+        case FIELDTYPE:
+        case ERROR:
+          res += std::format("\t; {}", chunk.names[in.a]);
+          break;
+
+        case CONST:
+          res += std::format("\t; {}", chunk.constants[in.a].value());
+          break;
+
+        default:
+          break;
+      }
+
+      res += "\n";
+    }
+
+    return res;
+  }
+};
+#endif
@@ -0,0 +1,141 @@
+/*
+**  Author: Aniket Biswas (xunicatt)
+**  Github: https://github.com/xunicatt
+**  Description: Instruction set and compiled program layout for the eta vm
+**  File: bytecode.h
+*/
+
+#ifndef __BYTECODE_H__
+#define __BYTECODE_H__
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <ast.h>
+#include <lexer.h>
+#include <object.h>
+#include <token.h>
+
+namespace bytecode {
+// every instruction carries two operands (a, b) and an index into
+// Chunk::locations (loc), instructions reporting more than one location
+// use the consecutive entries starting at loc
+enum OpCode {
+  HALT = 0,
+  POP,
+  CONST,        // push constants[a]
+  NULL_,
+  TRUE,
+  FALSE,
+
+  GET,          // push variables[a]
+  LETCHECK,     // variables[a] must not exist in the current scope
+  LET,          // pop into variables[a] of the current scope
+  ASSIGNCHECK,  // push the current value of variables[a]
+  ASSIGN,       // pop value and old value, update variables[a]
+  OPASSIGN,     // pop value, update variables[a]
+
+  UNARY,        // a: operator
+  BINARY,       // a: operator
+  ARRAY,        // a: element count
+
+  INDEX,        // locs: expr, index, left
+  INDEXCHECK,   // locs: left
+  INDEXKEY,     // locs: index
+  INDEXSET,     // locs: right
+
+  MEMBER,       // a: field name, b: caches[b], locs: left, field
+  MEMBERCHECK,  // a: field name, b: caches[b], locs: left, field
+  MEMBERSET,    // a: field name, b: caches[b], locs: field
+
+  STRUCTCHECK,  // locs: struct name
+  FIELDCHECK,   // a: field name, b: position of the struct on the stack
+  FIELDTYPE,    // a: field name
+  STRUCTLIT,    // a: shapes[a]
+
+  PRECALL,      // a: argc
+  CALL,         // a: argc, locs: function, args...
+  TAILCALL,     // a: argc, locs: function, args... reruns the frame on itself
+  RETURN,
+
+  TRY,          // a: handler address
+  ENDTRY,
+  JUMP,         // a: address
+  JUMPIFNOT,    // a: address, pops a bool
+
+  PUSHSCOPE,    // a: layouts[a]
+  POPSCOPE,
+  POPSCOPES,    // a: count
+
+  FUNC,         // push a function for chunks[a]
+  SET,          // pop into variables[a] of the current scope
+  STRUCT,       // define structs[a]
+  EXTERN,       // define externs[a]
+  ERROR,        // raise names[a]
+  __OPCODECOUNT__,
+};
+
+struct Instr {
+  OpCode op;
+  uint32_t a;
+  uint32_t b;
+  uint32_t loc;
+};
+
+// the shape of the struct last accessed by a member instruction and the
+// slot its field has in it
+struct MemberCache {
+  uint64_t shape = 0;
+  uint32_t slot = 0;
+};
+
+// the symbols of a scope's variables in slot order
+using Layout = std::vector<uint32_t>;
+
+// names are variables[name], variables[libname] and variables[funcname]
+struct StructDef {
+  uint32_t name;
+  std::map<std::string, std::string> fields;
+};
+
+struct ExternDef {
+  uint32_t libname;
+  uint32_t funcname;
+  std::vector<token::Token> argtypes;
+  token::Token rettype;
+};
+
+struct Chunk {
+  std::string name;
+  std::vector<ast::Identifier> parameters;
+  // the scope layout of a function's body
+  Layout layout;
+  std::vector<Instr> code;
+  std::vector<ObjectRef> constants;
+  std::vector<std::string> names;
+  std::vector<ast::Identifier> variables;
+  // symbols[i] is the symbol of variables[i]
+  std::vector<uint32_t> symbols;
+  std::vector<Layout> layouts;
+  std::vector<Location> locations;
+  std::vector<std::vector<std::string>> shapes;
+  mutable std::vector<MemberCache> caches;
+  std::vector<StructDef> structs;
+  std::vector<ExternDef> externs;
+};
+
+// chunks[0] is the program itself, the rest are its functions. every
+// variable name in the program is a symbol, its index in symbols
+struct Module {
+  std::vector<std::unique_ptr<Chunk>> chunks;
+  std::vector<std::string> symbols;
+};
+
+#ifdef BYTECODE_DEBUG_INFO_ENABLE
+  std::string to_string(const Chunk&);
+#endif
+};
+
+#endif
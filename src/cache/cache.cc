@@ -0,0 +1,1072 @@
+#include <cache.h>
+#include <ast.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <lexer.h>
+#include <map>
+#include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <token.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+using ast::ExprType;
+using ast::StmtType;
+
+namespace cache {
+// a cache file is the header below followed by the encoded statements:
+//   magic, format, version, source path, source size, source hash,
+//   payload hash
+// the payload is the table of texts and then the statements.
+// numbers are stored in host byte order, the cache never leaves the
+// machine that wrote it. bump FORMAT whenever the encoding or the ast
+// changes
+static constexpr std::string_view MAGIC = "etac";
+static constexpr uint32_t FORMAT = 3;
+static constexpr std::string_view VERSION = "v0.0.3";
+
+// written in place of a node that is not there (a missing else, an
+// empty for clause, a bare return)
+static constexpr uint8_t NONE = 0xff;
+
+// fnv-1a taken a word at a time, it only has to notice a changed
+// source or a damaged file
+static uint64_t
+hash(std::string_view s, uint64_t h = 0xcbf29ce484222325ULL) {
+  constexpr uint64_t PRIME = 0x100000001b3ULL;
+  size_t i = 0;
+  for(; i + sizeof(uint64_t) <= s.size(); i += sizeof(uint64_t)) {
+    uint64_t w;
+    std::memcpy(&w, s.data() + i, sizeof(w));
+    h = (h ^ w) * PRIME;
+    h ^= h >> 32;
+  }
+
+  for(; i < s.size(); i++) {
+    h = (h ^ static_cast<unsigned char>(s[i])) * PRIME;
+  }
+  return h;
+}
+
+class Writer {
+public:
+  template<typename T>
+  void num(T value) {
+    bytes.append(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  void str(std::string_view s) {
+    num<uint32_t>(s.size());
+    bytes.append(s);
+  }
+
+  // names and literals repeat a lot, each one is kept once in a table
+  // written ahead of the nodes and referred to by its index
+  void text(std::string_view s) {
+    auto [it, added] = texts.try_emplace(s, table.size());
+    if(added) {
+      table.push_back(s);
+    }
+    num<uint32_t>(it->second);
+  }
+
+  std::string bytes;
+  std::vector<std::string_view> table;
+
+private:
+  std::unordered_map<std::string_view, uint32_t> texts;
+};
+
+// every read is bounds checked, the first one past the end clears ok
+// and the ones after it return zeros
+class Reader {
+public:
+  Reader(std::string_view data): data(data) {}
+
+  template<typename T>
+  T num() {
+    T value = {};
+    std::string_view b = bytes(sizeof(T));
+    if(ok) {
+      std::memcpy(&value, b.data(), sizeof(T));
+    }
+    return value;
+  }
+
+  std::string_view bytes(size_t n) {
+    if(!ok || data.size() - at < n) {
+      ok = false;
+      return {};
+    }
+
+    std::string_view b = data.substr(at, n);
+    at += n;
+    return b;
+  }
+
+  std::string_view str() {
+    return bytes(num<uint32_t>());
+  }
+
+  std::string_view rest() {
+    return bytes(data.size() - at);
+  }
+
+  bool done() const {
+    return at == data.size();
+  }
+
+  bool ok = true;
+
+private:
+  std::string_view data;
+  size_t at = 0;
+};
+
+//====================================================
+// ENCODING
+static void encode(Writer&, const ast::ExprRef&);
+static void encode(Writer&, const ast::StmtRef&);
+static void encode(Writer&, const ast::BlockStmtRef&);
+static void encode(Writer&, const ast::IdentifierRef&);
+
+static void
+encode(Writer& out, const Location& loc) {
+  out.num(loc.offset);
+}
+
+static void
+encode(Writer& out, token::Token t) {
+  out.num<uint8_t>(t);
+}
+
+template<typename T>
+static void
+encode(Writer& out, const std::vector<T>& items) {
+  out.num<uint32_t>(items.size());
+  for(const auto& item: items) {
+    encode(out, item);
+  }
+}
+
+static void
+encode(Writer& out, const ast::Layout& layout) {
+  out.num<uint32_t>(layout.names.size());
+  for(const auto& name: layout.names) {
+    out.text(name);
+  }
+}
+
+static void
+encode(Writer& out, const ast::Identifier& e) {
+  encode(out, e.location);
+  out.text(e.value);
+  out.num(e.slot.depth);
+  out.num(e.slot.index);
+}
+
+static void
+encode(Writer& out, const ast::NullLit& e) {
+  encode(out, e.location);
+}
+
+static void
+encode(Writer& out, const ast::IntegerLit& e) {
+  encode(out, e.location);
+  out.num(e.value);
+}
+
+static void
+encode(Writer& out, const ast::FloatLit& e) {
+  encode(out, e.location);
+  out.num(e.value);
+}
+
+static void
+encode(Writer& out, const ast::BoolLit& e) {
+  encode(out, e.location);
+  out.num<uint8_t>(e.value);
+}
+
+static void
+encode(Writer& out, const ast::StringLit& e) {
+  encode(out, e.location);
+  out.text(*e.value);
+}
+
+static void
+encode(Writer& out, const ast::ArrayLit& e) {
+  encode(out, e.location);
+  encode(out, e.elements);
+}
+
+static void
+encode(Writer& out, const ast::StructLit& e) {
+  encode(out, e.location);
+  encode(out, e.name);
+  encode(out, e.names);
+  encode(out, e.value);
+}
+
+static void
+encode(Writer& out, const ast::UnaryExpr& e) {
+  encode(out, e.location);
+  encode(out, e.operator_);
+  encode(out, e.right);
+}
+
+static void
+encode(Writer& out, const ast::BinaryExpr& e) {
+  encode(out, e.location);
+  encode(out, e.operator_);
+  encode(out, e.left);
+  encode(out, e.right);
+}
+
+static void
+encode(Writer& out, const ast::AssignmentExpr& e) {
+  encode(out, e.location);
+  encode(out, e.left);
+  encode(out, e.right);
+}
+
+static void
+encode(Writer& out, const ast::CallExpr& e) {
+  encode(out, e.location);
+  encode(out, e.function);
+  encode(out, e.arguments);
+}
+
+static void
+encode(Writer& out, const ast::IndexExpr& e) {
+  encode(out, e.location);
+  encode(out, e.left);
+  encode(out, e.index);
+}
+
+static void
+encode(Writer& out, const ast::OpAssignmentExpr& e) {
+  encode(out, e.location);
+  encode(out, e.operator_);
+  encode(out, e.left);
+  encode(out, e.right);
+}
+
+static void
+encode(Writer& out, const ast::MemberExpr& e) {
+  encode(out, e.location);
+  encode(out, e.left);
+  encode(out, e.field);
+}
+
+static void
+encode(Writer& out, const ast::StructStmt& s) {
+  encode(out, s.name);
+  encode(out, s.types);
+  encode(out, s.names);
+}
+
+static void
+encode(Writer& out, const ast::LetStmt& s) {
+  encode(out, s.name);
+  encode(out, s.value);
+}
+
+static void
+encode(Writer& out, const ast::ReturnStmt& s) {
+  encode(out, s.value);
+  out.num<uint8_t>(s.tail);
+}
+
+static void
+encode(Writer& out, const ast::IfStmt& s) {
+  encode(out, s.condition);
+  encode(out, s.consequence);
+  encode(out, s.alternative);
+  encode(out, s.layout);
+}
+
+static void
+encode(Writer& out, const ast::ForStmt& s) {
+  encode(out, s.pre);
+  encode(out, s.condition);
+  encode(out, s.post);
+  encode(out, s.body);
+  encode(out, s.layout);
+}
+
+static void
+encode(Writer& out, const ast::FunctionStmt& s) {
+  encode(out, s.name);
+  encode(out, s.parameters);
+  encode(out, s.body);
+}
+
+static void
+encode(Writer& out, const ast::ExprStmt& s) {
+  encode(out, s.expr);
+}
+
+static void
+encode(Writer& out, const ast::ExternStmt& s) {
+  encode(out, s.libname);
+  encode(out, s.funcname);
+  encode(out, s.argtypes);
+  encode(out, s.rettype);
+}
+
+static void
+encode(Writer& out, const ast::ExprRef& e) {
+  if(e == nullptr) {
+    out.num(NONE);
+    return;
+  }
+
+  out.num<uint8_t>(e->type);
+  std::visit([&out](const auto& child) { encode(out, child); }, e->child);
+}
+
+static void
+encode(Writer& out, const ast::StmtRef& s) {
+  if(s == nullptr) {
+    out.num(NONE);
+    return;
+  }
+
+  out.num<uint8_t>(s->type);
+  std::visit([&out](const auto& child) { encode(out, child); }, s->child);
+}
+
+static void
+encode(Writer& out, const ast::BlockStmtRef& b) {
+  if(b == nullptr) {
+    out.num(NONE);
+    return;
+  }
+
+  out.num<uint8_t>(StmtType::BLOCKSTMT);
+  encode(out, b->stmts);
+  encode(out, b->layout);
+}
+
+static void
+encode(Writer& out, const ast::IdentifierRef& e) {
+  if(e == nullptr) {
+    out.num(NONE);
+    return;
+  }
+
+  out.num<uint8_t>(ExprType::IDENTEXPR);
+  encode(out, *e);
+}
+
+//====================================================
+// DECODING
+// rebuilds the nodes in the arena of prgm, string literals are interned
+// again the way the parser does it
+class Decoder {
+public:
+  Decoder(Reader& in, ast::Program& prgm, size_t limit)
+    : in(in), prgm(prgm), limit(limit) {}
+
+  // false when the payload does not hold exactly one well formed program
+  bool program();
+
+private:
+  ast::ExprRef expr();
+  ast::StmtRef stmt();
+  ast::BlockStmtRef block();
+  ast::IdentifierRef ident();
+  template<typename T>
+  std::vector<T> list(T (Decoder::*)());
+  template<typename T>
+  ast::ExprRef node(ExprType, T&&);
+  template<typename T>
+  ast::StmtRef node(StmtType, T&&);
+  Location location();
+  token::Token token();
+  ast::Layout layout();
+  ast::Identifier identifier();
+  std::string_view text();
+  ast::Constant constant(std::string_view);
+  // reads a node's tag, false for a missing node or a bad tag
+  bool tag(uint8_t&, uint8_t);
+
+  Reader& in;
+  ast::Program& prgm;
+  size_t limit;
+  // views into the mapped file, valid while decoding
+  std::vector<std::string_view> texts;
+  std::map<std::string, ast::Constant, std::less<>> constants;
+};
+
+template<typename T>
+std::vector<T>
+Decoder::list(T (Decoder::*item)()) {
+  uint32_t n = in.num<uint32_t>();
+  std::vector<T> items;
+  for(uint32_t i = 0; i < n && in.ok; i++) {
+    items.push_back((this->*item)());
+  }
+  return items;
+}
+
+template<typename T>
+ast::ExprRef
+Decoder::node(ExprType type, T&& child) {
+  return prgm.arena.make(ast::Expr{.type = type, .child = std::move(child)});
+}
+
+template<typename T>
+ast::StmtRef
+Decoder::node(StmtType type, T&& child) {
+  return prgm.arena.make(ast::Stmt{.type = type, .child = std::move(child)});
+}
+
+Location
+Decoder::location() {
+  uint32_t offset = in.num<uint32_t>();
+  if(offset > limit) {
+    in.ok = false;
+  }
+  return Location{.offset = offset};
+}
+
+token::Token
+Decoder::token() {
+  uint8_t t = in.num<uint8_t>();
+  if(t >= token::__TOKENCOUNT__) {
+    in.ok = false;
+    return token::Token::NONE;
+  }
+  return static_cast<token::Token>(t);
+}
+
+ast::Layout
+Decoder::layout() {
+  ast::Layout layout;
+  uint32_t n = in.num<uint32_t>();
+  for(uint32_t i = 0; i < n && in.ok; i++) {
+    layout.names.emplace_back(text());
+  }
+  return layout;
+}
+
+ast::Identifier
+Decoder::identifier() {
+  ast::Identifier e;
+  e.location = location();
+  e.value = text();
+  e.slot.depth = in.num<int32_t>();
+  e.slot.index = in.num<uint32_t>();
+  return e;
+}
+
+std::string_view
+Decoder::text() {
+  uint32_t i = in.num<uint32_t>();
+  if(i >= texts.size()) {
+    in.ok = false;
+    return {};
+  }
+  return texts[i];
+}
+
+ast::Constant
+Decoder::constant(std::string_view value) {
+  auto it = constants.find(value);
+  if(it == constants.end()) {
+    it = constants.emplace(value, std::make_shared<std::string>(value)).first;
+  }
+  return it->second;
+}
+
+bool
+Decoder::tag(uint8_t& t, uint8_t count) {
+  t = in.num<uint8_t>();
+  if(!in.ok || t == NONE) {
+    return false;
+  }
+
+  if(t >= count) {
+    in.ok = false;
+    return false;
+  }
+  return true;
+}
+
+ast::ExprRef
+Decoder::expr() {
+  uint8_t t;
+  if(!tag(t, ExprType::__EXPRNODECOUNT__)) {
+    return nullptr;
+  }
+
+  ExprType type = static_cast<ExprType>(t);
+  switch(type) {
+    case ExprType::IDENTEXPR:
+      return node(type, identifier());
+
+    case ExprType::NULLLIT:
+      return node(type, ast::NullLit{.location = location()});
+
+    case ExprType::INTEGERLIT:
+      return node(type, ast::IntegerLit{.location = location(), .value = in.num<int64_t>()});
+
+    case ExprType::FLOATLIT:
+      return node(type, ast::FloatLit{.location = location(), .value = in.num<double>()});
+
+    case ExprType::BOOLLIT:
+      return node(type, ast::BoolLit{.location = location(), .value = in.num<uint8_t>() != 0});
+
+    case ExprType::STRINGLIT:
+      return node(type, ast::StringLit{.location = location(), .value = constant(text())});
+
+    case ExprType::ARRAYLIT:
+      return node(type, ast::ArrayLit{.location = location(), .elements = list(&Decoder::expr)});
+
+    case ExprType::STRUCTLIT:
+      return node(type, ast::StructLit{
+        .location = location(),
+        .name = expr(),
+        .names = list(&Decoder::ident),
+        .value = list(&Decoder::expr)
+      });
+
+    case ExprType::UNARYEXP:
+      return node(type, ast::UnaryExpr{
+        .location = location(),
+        .operator_ = token(),
+        .right = expr()
+      });
+
+    case ExprType::BINARYEXP:
+      return node(type, ast::BinaryExpr{
+        .location = location(),
+        .operator_ = token(),
+        .left = expr(),
+        .right = expr()
+      });
+
+    case ExprType::ASSIGNMENTEXP:
+      return node(type, ast::AssignmentExpr{
+        .location = location(),
+        .left = expr(),
+        .right = expr()
+      });
+
+    case ExprType::OPASSIGNMENTEXP:
+      return node(type, ast::OpAssignmentExpr{
+        .location = location(),
+        .operator_ = token(),
+        .left = expr(),
+        .right = expr()
+      });
+
+    case ExprType::CALLEXP:
+      return node(type, ast::CallExpr{
+        .location = location(),
+        .function = expr(),
+        .arguments = list(&Decoder::expr)
+      });
+
+    case ExprType::INDEXEXP:
+      return node(type, ast::IndexExpr{
+        .location = location(),
+        .left = expr(),
+        .index = expr()
+      });
+
+    case ExprType::MEMBEREXP:
+      return node(type, ast::MemberExpr{
+        .location = location(),
+        .left = expr(),
+        .field = ident()
+      });
+
+    default:
+      in.ok = false;
+      return nullptr;
+  }
+}
+
+ast::StmtRef
+Decoder::stmt() {
+  uint8_t t;
+  if(!tag(t, StmtType::__STMTNODECOUNT__)) {
+    return nullptr;
+  }
+
+  StmtType type = static_cast<StmtType>(t);
+  switch(type) {
+    case StmtType::STRUCTSTMT:
+      return node(type, ast::StructStmt{
+        .name = ident(),
+        .types = list(&Decoder::ident),
+        .names = list(&Decoder::ident)
+      });
+
+    case StmtType::LETSTMT:
+      return node(type, ast::LetStmt{.name = ident(), .value = expr()});
+
+    case StmtType::RETURNSTMT:
+      return node(type, ast::ReturnStmt{.value = expr(), .tail = in.num<uint8_t>() != 0});
+
+    case StmtType::EXPRESSIONSTMT:
+      return node(type, ast::ExprStmt{.expr = expr()});
+
+    case StmtType::IFSTMT:
+      return node(type, ast::IfStmt{
+        .condition = expr(),
+        .consequence = block(),
+        .alternative = block(),
+        .layout = layout()
+      });
+
+    case StmtType::FORSTMT:
+      return node(type, ast::ForStmt{
+        .pre = stmt(),
+        .condition = expr(),
+        .post = expr(),
+        .body = block(),
+        .layout = layout()
+      });
+
+    case StmtType::FUNCTIONSTMT:
+      return node(type, ast::FunctionStmt{
+        .name = ident(),
+        .parameters = list(&Decoder::ident),
+        .body = block()
+      });
+
+    case StmtType::EXTERNSTMT:
+      return node(type, ast::ExternStmt{
+        .libname = ident(),
+        .funcname = ident(),
+        .argtypes = list(&Decoder::token),
+        .rettype = token()
+      });
+
+    default:
+      // blocks only appear as children of other statements
+      in.ok = false;
+      return nullptr;
+  }
+}
+
+ast::BlockStmtRef
+Decoder::block() {
+  uint8_t t;
+  if(!tag(t, StmtType::__STMTNODECOUNT__)) {
+    return nullptr;
+  }
+
+  if(t != StmtType::BLOCKSTMT) {
+    in.ok = false;
+    return nullptr;
+  }
+
+  std::vector<ast::StmtRef> stmts = list(&Decoder::stmt);
+  return prgm.arena.make(ast::BlockStmt{
+    .stmts = std::move(stmts),
+    .layout = layout()
+  });
+}
+
+ast::IdentifierRef
+Decoder::ident() {
+  uint8_t t;
+  if(!tag(t, ExprType::__EXPRNODECOUNT__)) {
+    return nullptr;
+  }
+
+  if(t != ExprType::IDENTEXPR) {
+    in.ok = false;
+    return nullptr;
+  }
+
+  return prgm.arena.make(identifier());
+}
+
+bool
+Decoder::program() {
+  uint32_t n = in.num<uint32_t>();
+  for(uint32_t i = 0; i < n && in.ok; i++) {
+    texts.push_back(in.str());
+  }
+
+  prgm.stmts = list(&Decoder::stmt);
+  for(const auto& [_, constant]: constants) {
+    prgm.constants.push_back(constant);
+  }
+  return in.ok && in.done();
+}
+
+//====================================================
+// CHECKING
+// the payload hash only proves the file is the one that was written.
+// the evaluators index scopes with the decoded slots and follow the
+// decoded children without looking, so the tree is walked once more
+// with the frames the resolver had and anything they could not have
+// produced is turned away
+class Checker {
+public:
+  bool program(const ast::Program&);
+
+private:
+  bool expr(const ast::ExprRef&);
+  bool exprs(const std::vector<ast::ExprRef>&);
+  bool stmt(const ast::StmtRef&);
+  bool block(const ast::BlockStmtRef&);
+  bool func(const ast::FunctionStmt&);
+  bool ident(const ast::IdentifierRef&);
+  bool ident(const ast::Identifier&);
+  bool idents(const std::vector<ast::IdentifierRef>&);
+
+  // layouts of the scopes a slot can reach, innermost last
+  std::vector<const ast::Layout*> frames;
+};
+
+bool
+Checker::program(const ast::Program& prgm) {
+  for(const auto& s: prgm.stmts) {
+    if(!stmt(s)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool
+Checker::ident(const ast::Identifier& e) {
+  if(!ast::resolved(e.slot)) {
+    return true;
+  }
+
+  size_t depth = e.slot.depth;
+  return depth < frames.size() &&
+    e.slot.index < frames[frames.size() - 1 - depth]->names.size();
+}
+
+bool
+Checker::ident(const ast::IdentifierRef& e) {
+  return e != nullptr && ident(*e);
+}
+
+bool
+Checker::idents(const std::vector<ast::IdentifierRef>& items) {
+  for(const auto& e: items) {
+    if(!ident(e)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool
+Checker::exprs(const std::vector<ast::ExprRef>& items) {
+  for(const auto& e: items) {
+    if(!expr(e)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool
+Checker::expr(const ast::ExprRef& e) {
+  if(e == nullptr) {
+    return false;
+  }
+
+  switch(e->type) {
+    case ExprType::IDENTEXPR:
+      return ident(std::get<ast::Identifier>(e->child));
+
+    case ExprType::ARRAYLIT:
+      return exprs(std::get<ast::ArrayLit>(e->child).elements);
+
+    case ExprType::STRUCTLIT: {
+      auto& s = std::get<ast::StructLit>(e->child);
+      return expr(s.name) && idents(s.names) && exprs(s.value) &&
+        s.names.size() == s.value.size();
+    }
+
+    case ExprType::UNARYEXP:
+      return expr(std::get<ast::UnaryExpr>(e->child).right);
+
+    case ExprType::BINARYEXP: {
+      auto& binary = std::get<ast::BinaryExpr>(e->child);
+      return expr(binary.left) && expr(binary.right);
+    }
+
+    case ExprType::ASSIGNMENTEXP: {
+      auto& assign = std::get<ast::AssignmentExpr>(e->child);
+      return expr(assign.left) && expr(assign.right);
+    }
+
+    case ExprType::OPASSIGNMENTEXP: {
+      auto& opassign = std::get<ast::OpAssignmentExpr>(e->child);
+      return expr(opassign.left) && expr(opassign.right);
+    }
+
+    case ExprType::CALLEXP: {
+      auto& call = std::get<ast::CallExpr>(e->child);
+      return expr(call.function) && exprs(call.arguments);
+    }
+
+    case ExprType::INDEXEXP: {
+      auto& index = std::get<ast::IndexExpr>(e->child);
+      return expr(index.left) && expr(index.index);
+    }
+
+    case ExprType::MEMBEREXP: {
+      auto& member = std::get<ast::MemberExpr>(e->child);
+      return expr(member.left) && ident(member.field);
+    }
+
+    default:
+      return true;
+  }
+}
+
+bool
+Checker::block(const ast::BlockStmtRef& b) {
+  if(b == nullptr) {
+    return false;
+  }
+
+  for(const auto& s: b->stmts) {
+    if(!stmt(s)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool
+Checker::func(const ast::FunctionStmt& f) {
+  if(f.body == nullptr) {
+    return false;
+  }
+
+  // a body only sees its own scope, as in the resolver
+  std::vector<const ast::Layout*> outer = std::move(frames);
+  frames = {&f.body->layout};
+  bool ok = idents(f.parameters) && block(f.body);
+  frames = std::move(outer);
+  return ok && ident(f.name);
+}
+
+bool
+Checker::stmt(const ast::StmtRef& s) {
+  if(s == nullptr) {
+    return false;
+  }
+
+  switch(s->type) {
+    case StmtType::EXPRESSIONSTMT:
+      return expr(std::get<ast::ExprStmt>(s->child).expr);
+
+    case StmtType::LETSTMT: {
+      auto& let = std::get<ast::LetStmt>(s->child);
+      return expr(let.value) && ident(let.name);
+    }
+
+    case StmtType::RETURNSTMT: {
+      auto& ret = std::get<ast::ReturnStmt>(s->child);
+      return ret.value == nullptr || expr(ret.value);
+    }
+
+    case StmtType::IFSTMT: {
+      auto& _if = std::get<ast::IfStmt>(s->child);
+      if(!expr(_if.condition)) {
+        return false;
+      }
+
+      frames.push_back(&_if.layout);
+      bool ok = block(_if.consequence) &&
+        (_if.alternative == nullptr || block(_if.alternative));
+      frames.pop_back();
+      return ok;
+    }
+
+    case StmtType::FORSTMT: {
+      auto& _for = std::get<ast::ForStmt>(s->child);
+      if(_for.body == nullptr) {
+        return false;
+      }
+
+      frames.push_back(&_for.layout);
+      bool ok = (_for.pre == nullptr || stmt(_for.pre)) &&
+        (_for.condition == nullptr || expr(_for.condition)) &&
+        (_for.post == nullptr || expr(_for.post));
+
+      frames.push_back(&_for.body->layout);
+      ok = ok && block(_for.body);
+      frames.pop_back();
+      frames.pop_back();
+      return ok;
+    }
+
+    case StmtType::FUNCTIONSTMT:
+      return func(std::get<ast::FunctionStmt>(s->child));
+
+    case StmtType::STRUCTSTMT: {
+      auto& _struct = std::get<ast::StructStmt>(s->child);
+      return ident(_struct.name) && idents(_struct.types) && idents(_struct.names) &&
+        _struct.types.size() == _struct.names.size();
+    }
+
+    case StmtType::EXTERNSTMT: {
+      auto& ext = std::get<ast::ExternStmt>(s->child);
+      return ident(ext.libname) && ident(ext.funcname);
+    }
+
+    default:
+      return false;
+  }
+}
+
+static ast::ProgramRef
+decode(std::string_view bytes, std::string_view source, std::string_view data) {
+  Reader header(bytes);
+  if(header.bytes(MAGIC.size()) != MAGIC ||
+    header.num<uint32_t>() != FORMAT ||
+    header.str() != VERSION ||
+    header.str() != source ||
+    header.num<uint64_t>() != data.size() ||
+    header.num<uint64_t>() != hash(data)
+  ) {
+    return nullptr;
+  }
+
+  uint64_t checksum = header.num<uint64_t>();
+  std::string_view payload = header.rest();
+  if(!header.ok || hash(payload) != checksum) {
+    return nullptr;
+  }
+
+  Reader in(payload);
+  ast::ProgramRef prgm = std::make_unique<ast::Program>();
+  Decoder decoder(in, *prgm, data.size());
+  if(!decoder.program()) {
+    return nullptr;
+  }
+
+  Checker checker;
+  if(!checker.program(*prgm)) {
+    return nullptr;
+  }
+  return prgm;
+}
+
+std::string
+path(const std::string& source, uint64_t variant) {
+  std::filesystem::path dir;
+  if(const char* d = std::getenv("ETA_CACHE_DIR"); d != nullptr && *d != '\0') {
+    dir = d;
+  } else if(const char* d = std::getenv("XDG_CACHE_HOME"); d != nullptr && *d != '\0') {
+    dir = std::filesystem::path(d) / "eta";
+  } else if(const char* d = std::getenv("HOME"); d != nullptr && *d != '\0') {
+    dir = std::filesystem::path(d) / ".cache" / "eta";
+  } else {
+    return "";
+  }
+
+  // one file per source file, a changed source is written over the
+  // entry of its earlier version so the cache only grows with the
+  // number of files run. a new interpreter gets new files
+  uint64_t key = hash(source, hash(VERSION) ^ FORMAT ^ (variant << 32));
+  std::string name(16, '0');
+  for(size_t i = 0; i < name.size(); i++) {
+    name[name.size() - 1 - i] = "0123456789abcdef"[(key >> (4 * i)) & 0xf];
+  }
+
+  return (dir / (name + ".etac")).string();
+}
+
+ast::ProgramRef
+load(const std::string& path, const std::string& source, std::string_view data) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if(fd < 0) {
+    return nullptr;
+  }
+
+  struct stat st;
+  if(fstat(fd, &st) != 0 || st.st_size <= 0) {
+    close(fd);
+    return nullptr;
+  }
+
+  size_t size = st.st_size;
+  void* bytes = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if(bytes == MAP_FAILED) {
+    return nullptr;
+  }
+
+  ast::ProgramRef prgm = decode(std::string_view(static_cast<const char*>(bytes), size), source, data);
+  munmap(bytes, size);
+  return prgm;
+}
+
+void
+store(
+  const std::string& path,
+  const std::string& source,
+  std::string_view data,
+  const ast::ProgramRef& prgm
+) {
+  Writer nodes;
+  encode(nodes, prgm->stmts);
+
+  Writer payload;
+  payload.num<uint32_t>(nodes.table.size());
+  for(const auto& t: nodes.table) {
+    payload.str(t);
+  }
+  payload.bytes.append(nodes.bytes);
+
+  Writer out;
+  out.bytes.append(MAGIC);
+  out.num(FORMAT);
+  out.str(VERSION);
+  out.str(source);
+  out.num<uint64_t>(data.size());
+  out.num(hash(data));
+  out.num(hash(payload.bytes));
+  out.bytes.append(payload.bytes);
+
+  std::error_code ec;
+  std::filesystem::path file(path);
+  std::filesystem::create_directories(file.parent_path(), ec);
+
+  // written aside and renamed over the old file, so a run that reads
+  // the cache at the same time sees either the old or the new one
+  std::string tmp = path + ".tmp" + std::to_string(getpid());
+  std::ofstream f(tmp, std::ios::binary);
+  f.write(out.bytes.data(), out.bytes.size());
+  f.close();
+
+  if(!f) {
+    std::filesystem::remove(tmp, ec);
+    return;
+  }
+
+  std::filesystem::rename(tmp, file, ec);
+  if(ec) {
+    std::filesystem::remove(tmp, ec);
+  }
+}
+};
\ No newline at end of file
@@ -0,0 +1,40 @@
+/*
+**  Author: Aniket Biswas (xunicatt)
+**  Github: https://github.com/xunicatt
+**  Description: on disk cache of parsed and resolved eta programs
+**  File: cache.h
+*/
+
+#ifndef __CACHE_H__
+#define __CACHE_H__
+
+#include <ast.h>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace cache {
+// file the compiled form of the source file at source is kept in, named
+// after a hash of its absolute path and the interpreter version inside
+// $ETA_CACHE_DIR, $XDG_CACHE_HOME/eta or ~/.cache/eta. programs built
+// with different options pass a different variant. empty when none of
+// them is set
+std::string path(const std::string& source, uint64_t variant = 0);
+
+// the program cached at path for this source, nullptr when the file is
+// missing, was written for another file, other contents or another
+// interpreter, or is damaged
+ast::ProgramRef load(const std::string& path, const std::string& source, std::string_view data);
+
+// writes a resolved program to path, replacing the entry kept for an
+// earlier version of the source. failures are ignored as the cache is
+// only a shortcut past lexing, parsing and resolving
+void store(
+  const std::string& path,
+  const std::string& source,
+  std::string_view data,
+  const ast::ProgramRef&
+);
+};
+
+#endif
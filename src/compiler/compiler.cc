@@ -0,0 +1,570 @@
+#include <compiler.h>
+#include <bytecode.h>
+#include <ast.h>
+#include <gc.h>
+#include <object.h>
+#include <token.h>
+#include <memory>
+#include <utility>
+#include <variant>
+
+using ast::StmtType;
+using ast::ExprType;
+using bytecode::OpCode;
+
+namespace compiler {
+Compiler::Compiler() {
+  chunk = nullptr;
+  depth = 0;
+  infunc = false;
+}
+
+bytecode::Module
+Compiler::compile(const ast::ProgramRef& prgm) {
+  module.chunks.push_back(std::make_unique<bytecode::Chunk>());
+  chunk = module.chunks.back().get();
+  chunk->name = "main";
+
+  for(const auto& _stmt: prgm->stmts) {
+    depth = 0;
+    stmt(_stmt);
+
+    // a top-level return only ends its own statement
+    for(uint32_t exit: exits) {
+      patch(exit);
+    }
+    exits.clear();
+  }
+
+  emit(OpCode::HALT);
+  return std::move(module);
+}
+
+// =====================================================================
+// STATEMENTS COMPILER
+// =====================================================================
+void
+Compiler::stmt(const ast::StmtRef& _stmt) {
+  switch(_stmt->type) {
+    case StmtType::EXPRESSIONSTMT:
+      expr(std::get<ast::ExprStmt>(_stmt->child).expr);
+      emit(OpCode::POP);
+      break;
+
+    case StmtType::LETSTMT:
+      let_stmt(std::get<ast::LetStmt>(_stmt->child));
+      break;
+
+    case StmtType::RETURNSTMT:
+      return_stmt(std::get<ast::ReturnStmt>(_stmt->child));
+      break;
+
+    case StmtType::IFSTMT:
+      if_stmt(std::get<ast::IfStmt>(_stmt->child));
+      break;
+
+    case StmtType::FORSTMT:
+      for_stmt(std::get<ast::ForStmt>(_stmt->child));
+      break;
+
+    case StmtType::FUNCTIONSTMT:
+      func_stmt(std::get<ast::FunctionStmt>(_stmt->child));
+      break;
+
+    case StmtType::STRUCTSTMT:
+      struct_stmt(std::get<ast::StructStmt>(_stmt->child));
+      break;
+
+    case StmtType::EXTERNSTMT:
+      extern_stmt(std::get<ast::ExternStmt>(_stmt->child));
+      break;
+
+    default:
+      break;
+  }
+}
+
+void
+Compiler::let_stmt(const ast::LetStmt& _stmt) {
+  uint32_t n = variable(*_stmt.name);
+  emit(OpCode::LETCHECK, n, 0, location(_stmt.name->location));
+  expr(_stmt.value);
+  emit(OpCode::LET, n);
+}
+
+void
+Compiler::return_stmt(const ast::ReturnStmt& _stmt) {
+  if(_stmt.tail && infunc) {
+    call_expr(std::get<ast::CallExpr>(_stmt.value->child), OpCode::TAILCALL);
+  } else if(_stmt.value != nullptr) {
+    expr(_stmt.value);
+  } else {
+    emit(OpCode::NULL_);
+  }
+
+  if(infunc) {
+    emit(OpCode::RETURN);
+    return;
+  }
+
+  emit(OpCode::POP);
+  if(depth > 0) {
+    emit(OpCode::POPSCOPES, depth);
+  }
+  exits.push_back(emit(OpCode::JUMP));
+}
+
+void
+Compiler::if_stmt(const ast::IfStmt& _stmt) {
+  expr(_stmt.condition);
+  uint32_t jump = emit(OpCode::JUMPIFNOT, 0, 0, location(ast::location(_stmt.condition)));
+
+  uint32_t layout = scope(_stmt.layout);
+  emit(OpCode::PUSHSCOPE, layout);
+  depth++;
+  block_stmt(_stmt.consequence);
+  depth--;
+  emit(OpCode::POPSCOPE);
+
+  if(_stmt.alternative == nullptr) {
+    patch(jump);
+    return;
+  }
+
+  uint32_t end = emit(OpCode::JUMP);
+  patch(jump);
+
+  emit(OpCode::PUSHSCOPE, layout);
+  depth++;
+  block_stmt(_stmt.alternative);
+  depth--;
+  emit(OpCode::POPSCOPE);
+
+  patch(end);
+}
+
+void
+Compiler::for_stmt(const ast::ForStmt& _stmt) {
+  if(_stmt.body->stmts.size() == 0) {
+    return;
+  }
+
+  emit(OpCode::PUSHSCOPE, scope(_stmt.layout));
+  depth++;
+
+  if(_stmt.pre != nullptr) {
+    stmt(_stmt.pre);
+  }
+
+  uint32_t loop = here();
+  uint32_t exit = 0;
+  if(_stmt.condition != nullptr) {
+    expr(_stmt.condition);
+    exit = emit(OpCode::JUMPIFNOT, 0, 0, location(ast::location(_stmt.condition)));
+  }
+
+  emit(OpCode::PUSHSCOPE, scope(_stmt.body->layout));
+  depth++;
+  block_stmt(_stmt.body);
+  depth--;
+  emit(OpCode::POPSCOPE);
+
+  if(_stmt.post != nullptr) {
+    expr(_stmt.post);
+    emit(OpCode::POP);
+  }
+
+  emit(OpCode::JUMP, loop);
+  if(_stmt.condition != nullptr) {
+    patch(exit);
+  }
+
+  depth--;
+  emit(OpCode::POPSCOPE);
+}
+
+void
+Compiler::func_stmt(const ast::FunctionStmt& _stmt) {
+  uint32_t index = module.chunks.size();
+  module.chunks.push_back(std::make_unique<bytecode::Chunk>());
+
+  bytecode::Chunk* outer = chunk;
+  std::map<std::string, uint32_t> outernames = std::move(names);
+  size_t outerdepth = depth;
+  bool outerinfunc = infunc;
+
+  chunk = module.chunks.back().get();
+  chunk->name = _stmt.name->value;
+  chunk->layout = layout(_stmt.body->layout);
+  for(const auto& p: _stmt.parameters) {
+    chunk->parameters.push_back(*p);
+  }
+
+  names.clear();
+  depth = 0;
+  infunc = true;
+
+  block_stmt(_stmt.body);
+  emit(OpCode::NULL_);
+  emit(OpCode::RETURN);
+
+  chunk = outer;
+  names = std::move(outernames);
+  depth = outerdepth;
+  infunc = outerinfunc;
+
+  emit(OpCode::FUNC, index);
+  emit(OpCode::SET, variable(*_stmt.name));
+}
+
+void
+Compiler::struct_stmt(const ast::StructStmt& _stmt) {
+  bytecode::StructDef def = {
+    .name = variable(*_stmt.name),
+    .fields = {}
+  };
+
+  for(size_t i = 0; i < _stmt.names.size(); i++) {
+    def.fields[_stmt.names[i]->value] = _stmt.types[i]->value;
+  }
+
+  chunk->structs.push_back(std::move(def));
+  emit(OpCode::STRUCT, chunk->structs.size() - 1, 0, location(_stmt.name->location));
+}
+
+void
+Compiler::extern_stmt(const ast::ExternStmt& _stmt) {
+  chunk->externs.push_back(bytecode::ExternDef{
+    .libname = variable(*_stmt.libname),
+    .funcname = variable(*_stmt.funcname),
+    .argtypes = _stmt.argtypes,
+    .rettype = _stmt.rettype
+  });
+
+  uint32_t loc = location(_stmt.funcname->location);
+  location(_stmt.libname->location);
+  emit(OpCode::EXTERN, chunk->externs.size() - 1, 0, loc);
+}
+
+void
+Compiler::block_stmt(const ast::BlockStmtRef& _stmt) {
+  for(const auto& s: _stmt->stmts) {
+    stmt(s);
+  }
+}
+
+// =====================================================================
+// END
+// =====================================================================
+
+
+// =====================================================================
+// EXPRESSIONS COMPILER
+// =====================================================================
+void
+Compiler::expr(const ast::ExprRef& _expr) {
+  switch(_expr->type) {
+    case ExprType::NULLLIT:
+      emit(OpCode::NULL_);
+      break;
+
+    case ExprType::INTEGERLIT:
+      emit(OpCode::CONST, constant(Int{
+        .value = std::get<ast::IntegerLit>(_expr->child).value
+      }));
+      break;
+
+    case ExprType::FLOATLIT:
+      emit(OpCode::CONST, constant(Float{
+        .value = std::get<ast::FloatLit>(_expr->child).value
+      }));
+      break;
+
+    case ExprType::BOOLLIT:
+      emit(std::get<ast::BoolLit>(_expr->child).value ? OpCode::TRUE : OpCode::FALSE);
+      break;
+
+    case ExprType::STRINGLIT: {
+      ObjectRef obj = gc::alloc();
+      obj->type = ObjectType::STRING;
+      obj->child = String(std::get<ast::StringLit>(_expr->child).value);
+      emit(OpCode::CONST, constant(obj));
+      break;
+    }
+
+    case ExprType::ARRAYLIT: {
+      const auto& elements = std::get<ast::ArrayLit>(_expr->child).elements;
+      for(const auto& e: elements) {
+        expr(e);
+      }
+      emit(OpCode::ARRAY, elements.size());
+      break;
+    }
+
+    case ExprType::STRUCTLIT:
+      struct_lit(std::get<ast::StructLit>(_expr->child));
+      break;
+
+    case ExprType::IDENTEXPR: {
+      const auto& ident = std::get<ast::Identifier>(_expr->child);
+      emit(OpCode::GET, variable(ident), 0, location(ident.location));
+      break;
+    }
+
+    case ExprType::UNARYEXP: {
+      const auto& unary = std::get<ast::UnaryExpr>(_expr->child);
+      expr(unary.right);
+      emit(OpCode::UNARY, unary.operator_, 0, location(ast::location(unary.right)));
+      break;
+    }
+
+    case ExprType::BINARYEXP: {
+      const auto& binary = std::get<ast::BinaryExpr>(_expr->child);
+      expr(binary.left);
+      expr(binary.right);
+      emit(OpCode::BINARY, binary.operator_, 0, location(binary.location));
+      break;
+    }
+
+    case ExprType::ASSIGNMENTEXP:
+      assignment_expr(std::get<ast::AssignmentExpr>(_expr->child));
+      break;
+
+    case ExprType::OPASSIGNMENTEXP:
+      opassignment_expr(std::get<ast::OpAssignmentExpr>(_expr->child), ast::location(_expr));
+      break;
+
+    case ExprType::INDEXEXP: {
+      const auto& index = std::get<ast::IndexExpr>(_expr->child);
+      expr(index.left);
+      expr(index.index);
+      uint32_t loc = location(index.location);
+      location(ast::location(index.index));
+      location(ast::location(index.left));
+      emit(OpCode::INDEX, 0, 0, loc);
+      break;
+    }
+
+    case ExprType::CALLEXP:
+      call_expr(std::get<ast::CallExpr>(_expr->child));
+      break;
+
+    case ExprType::MEMBEREXP:
+      member_expr(std::get<ast::MemberExpr>(_expr->child));
+      break;
+
+    default:
+      emit(OpCode::NULL_);
+  }
+}
+
+// the tree walker reports its own diagnostic when some operands fail
+// to evaluate, instead of the operand's error, guarded() catches such
+// an error and pushes it as a value for the next instruction
+void
+Compiler::guarded(const ast::ExprRef& _expr) {
+  uint32_t handler = emit(OpCode::TRY);
+  expr(_expr);
+  emit(OpCode::ENDTRY);
+  patch(handler);
+}
+
+void
+Compiler::struct_lit(const ast::StructLit& s) {
+  guarded(s.name);
+  uint32_t loc = location(ast::location(s.name));
+  emit(OpCode::STRUCTCHECK, 0, 0, loc);
+
+  std::vector<std::string> shape;
+  for(size_t i = 0; i < s.names.size(); i++) {
+    uint32_t field = name(s.names[i]->value);
+    uint32_t fieldloc = location(s.names[i]->location);
+
+    emit(OpCode::FIELDCHECK, field, i, fieldloc);
+    expr(s.value[i]);
+    emit(OpCode::FIELDTYPE, field, i + 1, fieldloc);
+    shape.push_back(s.names[i]->value);
+  }
+
+  chunk->shapes.push_back(std::move(shape));
+  emit(OpCode::STRUCTLIT, chunk->shapes.size() - 1, 0, loc);
+}
+
+void
+Compiler::assignment_expr(const ast::AssignmentExpr& _expr) {
+  switch(_expr.left->type) {
+    case ExprType::IDENTEXPR: {
+      const auto& ident = std::get<ast::Identifier>(_expr.left->child);
+      uint32_t n = variable(ident);
+      uint32_t loc = location(ident.location);
+
+      emit(OpCode::ASSIGNCHECK, n, 0, loc);
+      expr(_expr.right);
+      emit(OpCode::ASSIGN, n, 0, loc);
+      break;
+    }
+
+    case ExprType::MEMBEREXP: {
+      const auto& member = std::get<ast::MemberExpr>(_expr.left->child);
+      uint32_t n = name(member.field->value);
+      uint32_t loc = location(ast::location(member.left));
+      uint32_t fieldloc = location(member.field->location);
+      uint32_t cache = chunk->caches.size();
+      chunk->caches.emplace_back();
+
+      guarded(member.left);
+      emit(OpCode::MEMBERCHECK, n, cache, loc);
+      guarded(_expr.right);
+      emit(OpCode::MEMBERSET, n, cache, fieldloc);
+      break;
+    }
+
+    case ExprType::INDEXEXP: {
+      const auto& index = std::get<ast::IndexExpr>(_expr.left->child);
+      expr(index.left);
+      emit(OpCode::INDEXCHECK, 0, 0, location(ast::location(index.left)));
+      expr(index.index);
+      emit(OpCode::INDEXKEY, 0, 0, location(ast::location(index.index)));
+      expr(_expr.right);
+      emit(OpCode::INDEXSET, 0, 0, location(ast::location(_expr.right)));
+      break;
+    }
+
+    default:
+      emit(
+        OpCode::ERROR,
+        name("constant cannot be assigned with a value"),
+        0,
+        location(ast::location(_expr.left))
+      );
+  }
+}
+
+void
+Compiler::opassignment_expr(const ast::OpAssignmentExpr& _expr, const Location& loc) {
+  if(_expr.left->type != ExprType::IDENTEXPR) {
+    emit(OpCode::ERROR, name("expected an non-indexed variable"), 0, location(loc));
+    return;
+  }
+
+  const auto& ident = std::get<ast::Identifier>(_expr.left->child);
+  uint32_t n = variable(ident);
+  uint32_t exprloc = location(loc);
+
+  emit(OpCode::GET, n, 0, location(ident.location));
+  expr(_expr.right);
+  emit(OpCode::BINARY, _expr.operator_, 0, exprloc);
+  emit(OpCode::OPASSIGN, n, 0, exprloc);
+}
+
+void
+Compiler::call_expr(const ast::CallExpr& _expr, OpCode op) {
+  expr(_expr.function);
+  emit(
+    OpCode::PRECALL,
+    _expr.arguments.size(),
+    0,
+    location(ast::location(_expr.function))
+  );
+
+  for(const auto& arg: _expr.arguments) {
+    expr(arg);
+  }
+
+  uint32_t loc = location(ast::location(_expr.function));
+  for(const auto& arg: _expr.arguments) {
+    location(ast::location(arg));
+  }
+
+  emit(op, _expr.arguments.size(), 0, loc);
+}
+
+void
+Compiler::member_expr(const ast::MemberExpr& _expr) {
+  guarded(_expr.left);
+  uint32_t loc = location(ast::location(_expr.left));
+  location(_expr.field->location);
+  chunk->caches.emplace_back();
+  emit(OpCode::MEMBER, name(_expr.field->value), chunk->caches.size() - 1, loc);
+}
+
+// =====================================================================
+// END
+// =====================================================================
+
+uint32_t
+Compiler::emit(bytecode::OpCode op, uint32_t a, uint32_t b, uint32_t loc) {
+  chunk->code.push_back(bytecode::Instr{
+    .op = op,
+    .a = a,
+    .b = b,
+    .loc = loc
+  });
+
+  return chunk->code.size() - 1;
+}
+
+uint32_t
+Compiler::here() const {
+  return chunk->code.size();
+}
+
+void
+Compiler::patch(uint32_t at) {
+  chunk->code[at].a = here();
+}
+
+uint32_t
+Compiler::location(const Location& loc) {
+  chunk->locations.push_back(loc);
+  return chunk->locations.size() - 1;
+}
+
+uint32_t
+Compiler::name(const std::string& value) {
+  if(names.contains(value)) {
+    return names.at(value);
+  }
+
+  chunk->names.push_back(value);
+  names[value] = chunk->names.size() - 1;
+  return chunk->names.size() - 1;
+}
+
+uint32_t
+Compiler::symbol(const std::string& value) {
+  auto [it, added] = symbols.try_emplace(value, module.symbols.size());
+  if(added) {
+    module.symbols.push_back(value);
+  }
+  return it->second;
+}
+
+uint32_t
+Compiler::variable(const ast::Identifier& ident) {
+  chunk->variables.push_back(ident);
+  chunk->symbols.push_back(symbol(ident.value));
+  return chunk->variables.size() - 1;
+}
+
+bytecode::Layout
+Compiler::layout(const ast::Layout& _layout) {
+  bytecode::Layout res;
+  for(const auto& n: _layout.names) {
+    res.push_back(symbol(n));
+  }
+  return res;
+}
+
+uint32_t
+Compiler::scope(const ast::Layout& _layout) {
+  chunk->layouts.push_back(layout(_layout));
+  return chunk->layouts.size() - 1;
+}
+
+uint32_t
+Compiler::constant(const ObjectRef& obj) {
+  chunk->constants.push_back(obj);
+  return chunk->constants.size() - 1;
+}
+};
@@ -0,0 +1,68 @@
+/*
+**  Author: Aniket Biswas (xunicatt)
+**  Github: https://github.com/xunicatt
+**  Description: compiles an eta program into bytecode for the vm
+**  File: compiler.h
+*/
+
+#ifndef __COMPILER_H__
+#define __COMPILER_H__
+
+#include <ast.h>
+#include <bytecode.h>
+#include <cstdint>
+#include <lexer.h>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace compiler {
+class Compiler {
+public:
+  Compiler();
+  bytecode::Module compile(const ast::ProgramRef&);
+
+private:
+  void stmt(const ast::StmtRef&);
+  void let_stmt(const ast::LetStmt&);
+  void return_stmt(const ast::ReturnStmt&);
+  void if_stmt(const ast::IfStmt&);
+  void for_stmt(const ast::ForStmt&);
+  void func_stmt(const ast::FunctionStmt&);
+  void struct_stmt(const ast::StructStmt&);
+  void extern_stmt(const ast::ExternStmt&);
+  void block_stmt(const ast::BlockStmtRef&);
+
+  void expr(const ast::ExprRef&);
+  void struct_lit(const ast::StructLit&);
+  void assignment_expr(const ast::AssignmentExpr&);
+  void opassignment_expr(const ast::OpAssignmentExpr&, const Location&);
+  void call_expr(const ast::CallExpr&, bytecode::OpCode = bytecode::OpCode::CALL);
+  void member_expr(const ast::MemberExpr&);
+  void guarded(const ast::ExprRef&);
+
+  uint32_t emit(bytecode::OpCode, uint32_t = 0, uint32_t = 0, uint32_t = 0);
+  uint32_t here() const;
+  void patch(uint32_t);
+  uint32_t location(const Location&);
+  uint32_t name(const std::string&);
+  uint32_t symbol(const std::string&);
+  uint32_t variable(const ast::Identifier&);
+  bytecode::Layout layout(const ast::Layout&);
+  uint32_t scope(const ast::Layout&);
+  uint32_t constant(const ObjectRef&);
+
+  bytecode::Module module;
+  bytecode::Chunk* chunk;
+  std::map<std::string, uint32_t> names;
+  // module wide, unlike names
+  std::map<std::string, uint32_t> symbols;
+  // scopes opened since the start of the current function or
+  // top-level statement, and the top-level returns to patch
+  size_t depth;
+  bool infunc;
+  std::vector<uint32_t> exits;
+};
+};
+
+#endif
@@ -87,25 +87,22 @@ blen(const std::vector<ObjectRef>& args) {
   ObjectRef obj = args.front();
   int64_t value = 0;
 
-  switch(obj->type) {
+  switch(obj.type()) {
     case ObjectType::STRING:
-      value = std::get<String>(obj->child).value.length();
+      value = std::get<String>(obj->child).value().length();
       break;
 
     case ObjectType::ARRAY:
-      value = std::get<Array>(obj->child).elements.size();
+      value = std::get<Array>(obj->child).size();
       break;
 
     default:
       return serr("type is not supported");
   }
 
-  ObjectRef res = gc::alloc();
-  res->type = ObjectType::INT;
-  res->child = Int{
+  return Int{
     .value = value
   };
-  return res;
 }
 
 static ObjectRef
@@ -122,9 +119,7 @@ bos(const std::vector<ObjectRef>& args) {
 
   ObjectRef res = gc::alloc();
   res->type = ObjectType::STRING;
-  res->child = String{
-    .value = OS
-  };
+  res->child = String(OS);
   return res;
 }
 
@@ -141,11 +136,11 @@ blib(const std::vector<ObjectRef>& args) {
   }
 
   ObjectRef obj = args.front();
-  if(obj->type != ObjectType::STRING) {
+  if(obj.type() != ObjectType::STRING) {
     return serr("expected string type as argument");
   }
 
-  const std::string& libname = std::get<String>(obj->child).value;
+  const std::string& libname = std::get<String>(obj->child).value();
   void* lib = dlopen(libname.c_str(), RTLD_LAZY);
   if(!lib) {
     return serr(
@@ -177,16 +172,14 @@ btype_of(const std::vector<ObjectRef>& args) {
   }
 
   const ObjectRef& obj = args.front();
-  std::string value = to_string(obj->type);
-  if(obj->type == ObjectType::STRUCTVAL) {
+  std::string value = to_string(obj.type());
+  if(obj.type() == ObjectType::STRUCTVAL) {
     value = std::get<Struct>(std::get<StructVal>(obj->child).parent->child).name;
   }
 
   ObjectRef res = gc::alloc();
   res->type = ObjectType::STRING;
-  res->child = String{
-    .value = value
-  };
+  res->child = String(value);
   return res;
 }
 
@@ -203,24 +196,20 @@ bto_int(const std::vector<ObjectRef>& args) {
   }
 
   ObjectRef obj = args.front();
-  ObjectRef res = gc::alloc();
-  res->type = ObjectType::INT;
 
-  switch(obj->type) {
+  switch(obj.type()) {
     case ObjectType::INT:
       return obj;
 
     case ObjectType::FLOAT:
-      res->child = Int{
-        .value = static_cast<int64_t>(std::get<Float>(obj->child).value)
+      return Int{
+        .value = static_cast<int64_t>(obj.as_float())
       };
-      return res;
 
     case ObjectType::BOOL:
-      res->child = Int{
-        .value = std::get<Bool>(obj->child).value
+      return Int{
+        .value = obj.as_bool()
       };
-      return res;
 
     default:
       return serr("type is not supported");
@@ -240,18 +229,15 @@ bto_float(const std::vector<ObjectRef>& args) {
   }
 
   ObjectRef obj = args.front();
-  ObjectRef res = gc::alloc();
-  res->type = ObjectType::FLOAT;
 
-  switch(obj->type) {
+  switch(obj.type()) {
     case ObjectType::FLOAT:
       return obj;
 
     case ObjectType::INT:
-      res->child = Float{
-        .value = static_cast<double>(std::get<Int>(obj->child).value)
+      return Float{
+        .value = static_cast<double>(obj.as_int())
       };
-      return res;
 
     default:
       return serr("type is not supported");
@@ -261,7 +247,7 @@ bto_float(const std::vector<ObjectRef>& args) {
 static ObjectRef
 bprint(const std::vector<ObjectRef>& args) {
   for(const auto& arg: args) {
-    std::print("{}", arg->value());
+    std::print("{}", arg.value());
   }
   return OBJECT_NULL;
 }
@@ -288,11 +274,11 @@ bpush(const std::vector<ObjectRef>& args) {
   ObjectRef arr = args[0];
   ObjectRef obj = args[1];
 
-  if(arr->type != ObjectType::ARRAY) {
+  if(arr.type() != ObjectType::ARRAY) {
     return serr("first argument must be 'array' type");
   }
 
-  std::get<Array>(arr->child).elements.push_back(obj);
+  std::get<Array>(arr->child).push(obj);
   return arr;
 }
 
@@ -310,11 +296,11 @@ bpop(const std::vector<ObjectRef>& args) {
 
   ObjectRef arr = args[0];
 
-  if(arr->type != ObjectType::ARRAY) {
+  if(arr.type() != ObjectType::ARRAY) {
     return serr("expected 'array' type");
   }
 
-  std::get<Array>(arr->child).elements.pop_back();
+  std::get<Array>(arr->child).pop();
   return arr;
 }
 
@@ -332,24 +318,24 @@ bslice(const std::vector<ObjectRef>& args) {
   }
 
   ObjectRef arr = args.front();
-  if(arr->type != ObjectType::ARRAY) {
+  if(arr.type() != ObjectType::ARRAY) {
     return serr("exepected 'array' type");
   }
 
 
   ObjectRef start_obj = args[1];
-  if(start_obj->type != ObjectType::INT) {
+  if(start_obj.type() != ObjectType::INT) {
     return serr("expected 'int' type as second argument");
   }
 
   ObjectRef end_obj = args[2];
-  if(end_obj->type != ObjectType::INT) {
+  if(end_obj.type() != ObjectType::INT) {
     return serr("expected 'int' type as third argument");
   }
 
-  int64_t start = std::get<Int>(start_obj->child).value;
-  int64_t end = std::get<Int>(end_obj->child).value;
-  auto& elements = std::get<Array>(arr->child).elements;
+  int64_t start = start_obj.as_int();
+  int64_t end = end_obj.as_int();
+  const Array& elements = std::get<Array>(arr->child);
 
   if(start < 0 || end > static_cast<int64_t>(elements.size()) || start >= end) {
     return serr("index out of range or invalid");
@@ -357,9 +343,7 @@ bslice(const std::vector<ObjectRef>& args) {
 
   ObjectRef cpy_arr = gc::alloc();
   cpy_arr->type = ObjectType::ARRAY;
-  cpy_arr->child = Array{
-    .elements = std::vector<ObjectRef>(elements.begin() + start, elements.begin() + end)
-  };
+  cpy_arr->child = elements.slice(start, end);
   return cpy_arr;
 }
 
@@ -377,12 +361,9 @@ bread_int(const std::vector<ObjectRef>& args) {
 
   int64_t value = 0;
   std::cin >> value;
-  ObjectRef res = gc::alloc();
-  res->type = ObjectType::INT;
-  res->child = Int{
+  return Int{
     .value = value
   };
-  return res;
 }
 
 static ObjectRef
@@ -399,12 +380,9 @@ bread_float(const std::vector<ObjectRef>& args) {
 
   double value = 0;
   std::cin >> value;
-  ObjectRef res = gc::alloc();
-  res->type = ObjectType::FLOAT;
-  res->child = Float{
+  return Float{
     .value = value
   };
-  return res;
 }
 
 static ObjectRef
@@ -424,9 +402,7 @@ bread_string(const std::vector<ObjectRef>& args) {
   std::getline(std::cin, value);
   ObjectRef res = gc::alloc();
   res->type = ObjectType::STRING;
-  res->child = String{
-    .value = value
-  };
+  res->child = String(value);
   return res;
 }
 
@@ -443,10 +419,14 @@ bclone(const std::vector<ObjectRef>& args) {
   }
 
   ObjectRef obj = args.front();
+  if(!obj.boxed()) {
+    return obj;
+  }
+
   ObjectRef res = gc::alloc();
-  res->type = obj->type;
+  res->type = obj.type();
 
-  switch(res->type) {
+  switch(res.type()) {
     case ObjectType::ARRAY:
       res->child = std::get<Array>(obj->child);
       break;
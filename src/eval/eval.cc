@@ -22,13 +22,9 @@ using ast::StmtType;
 using ast::ExprType;
 using token::Token;
 
-static Object ONULL = Object{.type = ObjectType::NULL_, .child = Null{}};
-static Object OTRUE = Object{.type = ObjectType::BOOL, .child = Bool{.value = true}};
-static Object OFALSE = Object{.type = ObjectType::BOOL, .child = Bool{.value = false}};
-
-extern const ObjectRef OBJECT_TRUE = &OTRUE;
-extern const ObjectRef OBJECT_NULL = &ONULL;
-extern const ObjectRef OBJECT_FALSE = &OFALSE;
+extern const ObjectRef OBJECT_TRUE = Bool{.value = true};
+extern const ObjectRef OBJECT_NULL = Null{};
+extern const ObjectRef OBJECT_FALSE = Bool{.value = false};
 extern const std::map<std::string, ObjectRef> builtinfns;
 
 static ObjectRef unaray_not(const ObjectRef&);
@@ -39,20 +35,75 @@ static ObjectRef binary(Token, const Float&, const Float&);
 static ObjectRef binary(Token, const String&, const String&);
 static ObjectType token_to_object_type(Token);
 static ffi_type* object_to_ffi_type(ObjectType);
-static void* object_to_data_ptr(ObjectRef&);
-static void object_set_child(ObjectRef&);
 
-Eval::Eval(Lexer& lexer)
-  :lexer(lexer) {}
+// storage for one argument or the return value of an external call
+union CValue {
+  int64_t i;
+  double f;
+  char* s;
+};
+
+static void* object_to_data_ptr(const ObjectRef&, CValue&);
+static ObjectRef data_to_object(ObjectType, const CValue&);
+
+#ifdef EVAL_THREADED_ENABLE
+  // a node's type always names the alternative its child holds, so the
+  // threaded dispatch skips the check std::get would repeat
+  template<typename T, typename V>
+  static inline T&
+  unchecked(V& child) {
+    T* node = std::get_if<T>(&child);
+    if(node == nullptr) {
+      __builtin_unreachable();
+    }
+    return *node;
+  }
+#endif
+
+// lowest address of the running thread's stack plus enough room to
+// build the stack overflow error, zero when it is unknown
+static uintptr_t
+stack_limit() {
+  constexpr uintptr_t MARGIN = 64 * 1024;
+  uintptr_t low = 0;
+
+  #ifdef __APPLE__
+    pthread_t self = pthread_self();
+    low = reinterpret_cast<uintptr_t>(pthread_get_stackaddr_np(self)) -
+      pthread_get_stacksize_np(self);
+  #else
+    pthread_attr_t attr;
+    if(pthread_getattr_np(pthread_self(), &attr) != 0) {
+      return 0;
+    }
+
+    void* addr = nullptr;
+    size_t size = 0;
+    if(pthread_attr_getstack(&attr, &addr, &size) == 0) {
+      low = reinterpret_cast<uintptr_t>(addr);
+    }
+    pthread_attr_destroy(&attr);
+  #endif
+
+  return low == 0 ? 0 : low + MARGIN;
+}
+
+Eval::Eval(Lexer& lexer, size_t max_stack)
+  :lexer(lexer),
+  max_stack(max_stack > 0 ? max_stack : SIZE_MAX),
+  stack_end(stack_limit()) {}
 
 ObjectRef
 Eval::evaluate(const ast::ProgramRef& prgm, Scope& scp) {
   ObjectRef result = OBJECT_NULL;
 
+  // a return outside of a function does not stop the program, its value
+  // is the value of the statement
   for(const auto& _stmt: prgm->stmts) {
-    result = stmt(_stmt, scp);
+    Completion res = stmt(_stmt, scp);
+    result = res.value;
 
-    if(is_err(result)) {
+    if(res.kind == Completion::ERROR) {
       return result;
     }
   }
@@ -63,14 +114,57 @@ Eval::evaluate(const ast::ProgramRef& prgm, Scope& scp) {
 // =====================================================================
 // STATEMENTS EVALUATOR
 // =====================================================================
-ObjectRef
+Completion
 Eval::stmt(const ast::StmtRef& stmt, Scope& scp) {
+  #ifdef EVAL_THREADED_ENABLE
+    // one indirect jump per node, the table is indexed by StmtType
+    static void* const dispatch[StmtType::__STMTNODECOUNT__] = {
+      &&do_struct_stmt,
+      &&do_let_stmt,
+      &&do_none,
+      &&do_return_stmt,
+      &&do_expr_stmt,
+      &&do_if_stmt,
+      &&do_for_stmt,
+      &&do_func_stmt,
+      &&do_extern_stmt
+    };
+
+    goto *dispatch[stmt->type];
+
+    do_struct_stmt:
+      return completion(struct_stmt(unchecked<ast::StructStmt>(stmt->child), scp));
+
+    do_let_stmt:
+      return completion(let_stmt(unchecked<ast::LetStmt>(stmt->child), scp));
+
+    do_return_stmt:
+      return return_stmt(unchecked<ast::ReturnStmt>(stmt->child), scp);
+
+    do_expr_stmt:
+      return completion(expr_stmt(unchecked<ast::ExprStmt>(stmt->child), scp));
+
+    do_if_stmt:
+      return if_stmt(unchecked<ast::IfStmt>(stmt->child), scp);
+
+    do_for_stmt:
+      return for_stmt(unchecked<ast::ForStmt>(stmt->child), scp);
+
+    do_func_stmt:
+      return completion(func_stmt(unchecked<ast::FunctionStmt>(stmt->child), scp));
+
+    do_extern_stmt:
+      return completion(extern_stmt(unchecked<ast::ExternStmt>(stmt->child), scp));
+
+    do_none:
+      return Completion{.kind = Completion::NORMAL, .value = OBJECT_NULL};
+  #else
   switch(stmt->type) {
     case StmtType::EXPRESSIONSTMT:
-      return expr_stmt(std::get<ast::ExprStmt>(stmt->child), scp);
+      return completion(expr_stmt(std::get<ast::ExprStmt>(stmt->child), scp));
 
     case StmtType::LETSTMT:
-      return let_stmt(std::get<ast::LetStmt>(stmt->child), scp);
+      return completion(let_stmt(std::get<ast::LetStmt>(stmt->child), scp));
 
     case StmtType::RETURNSTMT:
       return return_stmt(std::get<ast::ReturnStmt>(stmt->child), scp);
@@ -82,22 +176,23 @@ Eval::stmt(const ast::StmtRef& stmt, Scope& scp) {
       return for_stmt(std::get<ast::ForStmt>(stmt->child), scp);
 
     case StmtType::FUNCTIONSTMT:
-      return func_stmt(std::get<ast::FunctionStmt>(stmt->child), scp);
+      return completion(func_stmt(std::get<ast::FunctionStmt>(stmt->child), scp));
 
     case StmtType::STRUCTSTMT:
-      return struct_stmt(std::get<ast::StructStmt>(stmt->child), scp);
+      return completion(struct_stmt(std::get<ast::StructStmt>(stmt->child), scp));
 
     case StmtType::EXTERNSTMT:
-      return extern_stmt(std::get<ast::ExternStmt>(stmt->child), scp);
+      return completion(extern_stmt(std::get<ast::ExternStmt>(stmt->child), scp));
 
     default:
-      return OBJECT_NULL;
+      return Completion{.kind = Completion::NORMAL, .value = OBJECT_NULL};
   }
+  #endif
 }
 
 ObjectRef
 Eval::struct_stmt(ast::StructStmt& stmt, Scope& scp) {
-  if(scp.exists(stmt.name->value) || builtinfns.contains(stmt.name->value)) {
+  if(scp.exists(*stmt.name) || builtinfns.contains(stmt.name->value)) {
     return derr(stmt.name->location, "redefinition of variable");
   }
 
@@ -110,17 +205,14 @@ Eval::struct_stmt(ast::StructStmt& stmt, Scope& scp) {
 
   ObjectRef res = gc::alloc();
   res->type = ObjectType::STRUCT;
-  res->child = Struct{
-    .name = name,
-    .fields = fields
-  };
+  res->child = Struct(name, fields);
 
-  return scp.set(name, res);
+  return scp.set(*stmt.name, res);
 }
 
 ObjectRef
 Eval::let_stmt(const ast::LetStmt& stmt, Scope& scp) {
-  if(scp.exists(stmt.name->value) || builtinfns.contains(stmt.name->value)) {
+  if(scp.exists(*stmt.name) || builtinfns.contains(stmt.name->value)) {
     return derr(stmt.name->location, "redefinition of variable");
   }
 
@@ -129,44 +221,82 @@ Eval::let_stmt(const ast::LetStmt& stmt, Scope& scp) {
     return err;
   }
 
-  return scp.set(stmt.name->value, value);
+  return scp.set(*stmt.name, value);
 }
 
-ObjectRef
+Completion
 Eval::return_stmt(const ast::ReturnStmt& stmt, Scope& scp) {
-  ObjectRef retval = gc::alloc();
-  retval->type = ObjectType::RETVAL;
+  if(stmt.value == nullptr) {
+    return Completion{.kind = Completion::RETURN, .value = OBJECT_NULL};
+  }
+
+  if(stmt.tail) {
+    return tail_call(stmt, scp);
+  }
+
+  ObjectRef value = expr(stmt.value, scp);
+  if(auto err = derr(ast::location(stmt.value), value); is_err(err)) {
+    return completion(err);
+  }
+
+  return Completion{.kind = Completion::RETURN, .value = value};
+}
+
+// a call of the running function hands its arguments back to func(),
+// which rebinds them in the frame it already has. the resolver only
+// knows the name, any other callee is called as usual. kept out of
+// return_stmt so that plain returns do not pay its stack frame
+Completion
+Eval::tail_call(const ast::ReturnStmt& stmt, Scope& scp) {
+  const auto& _call = std::get<ast::CallExpr>(stmt.value->child);
+  ObjectRef funcobj = expr(_call.function, scp);
+  if(auto err = derr(ast::location(_call.function), funcobj); is_err(err)) {
+    return completion(err);
+  }
+
+  bool self = false;
+  if(funcobj.type() == ObjectType::FUNC) {
+    const Func& callee = std::get<Func>(funcobj->child);
+    self = callee.body == running && callee.parameters.size() == _call.arguments.size();
+  }
 
-  if(stmt.value != nullptr) {
-    ObjectRef value = expr(stmt.value, scp);
+  if(!self) {
+    ObjectRef value = call_expr(_call, scp, &funcobj);
     if(auto err = derr(ast::location(stmt.value), value); is_err(err)) {
-      return err;
+      return completion(err);
     }
-    retval->child = RetVal{
-      .value = value
-    };
-  } else {
-    retval->child = RetVal{
-      .value = OBJECT_NULL
-    };
+
+    return Completion{.kind = Completion::RETURN, .value = value};
   }
 
-  return retval;
+  // the arguments may call the function again, which reuses tailargs
+  std::vector<ObjectRef> args;
+  args.reserve(_call.arguments.size());
+  for(const auto& a: _call.arguments) {
+    ObjectRef value = expr(a, scp);
+    if(auto err = derr(ast::location(a), value); is_err(err)) {
+      return completion(err);
+    }
+    args.push_back(value);
+  }
+
+  tailargs = std::move(args);
+  return Completion{.kind = Completion::TAILCALL, .value = OBJECT_NULL};
 }
 
-ObjectRef
+Completion
 Eval::if_stmt(const ast::IfStmt& stmt, Scope& scp) {
   ObjectRef condval = expr(stmt.condition, scp);
   if(auto err = derr(ast::location(stmt.condition), condval); is_err(err)) {
-    return err;
+    return completion(err);
   }
 
-  if(condval->type != ObjectType::BOOL) {
-    return derr(ast::location(stmt.condition), "expected a boolean value");
+  if(condval.type() != ObjectType::BOOL) {
+    return completion(derr(ast::location(stmt.condition), "expected a boolean value"));
   }
 
-  Scope ifscp(&scp);
-  if(std::get<Bool>(condval->child).value) {
+  Scope ifscp(&scp, &stmt.layout);
+  if(condval.as_bool()) {
     return block_stmt(stmt.consequence, ifscp);
   }
 
@@ -174,19 +304,20 @@ Eval::if_stmt(const ast::IfStmt& stmt, Scope& scp) {
     return block_stmt(stmt.alternative, ifscp);
   }
 
-  return OBJECT_NULL;
+  return Completion{.kind = Completion::NORMAL, .value = OBJECT_NULL};
 }
 
-ObjectRef
+Completion
 Eval::for_stmt(const ast::ForStmt& _stmt, Scope& scp) {
+  Completion done = {.kind = Completion::NORMAL, .value = OBJECT_NULL};
   if(_stmt.body->stmts.size() == 0) {
-    return OBJECT_NULL;
+    return done;
   }
 
-  Scope for_header(&scp);
+  Scope for_header(&scp, &_stmt.layout);
   if(_stmt.pre != nullptr) {
-    ObjectRef res = stmt(_stmt.pre, for_header);
-    if(is_err(res)) {
+    Completion res = stmt(_stmt.pre, for_header);
+    if(res.kind == Completion::ERROR) {
       return res;
     }
   }
@@ -195,33 +326,33 @@ Eval::for_stmt(const ast::ForStmt& _stmt, Scope& scp) {
     if(_stmt.condition != nullptr) {
       ObjectRef condval = expr(_stmt.condition, for_header);
       if(auto err = derr(ast::location(_stmt.condition), condval); is_err(err)) {
-        return err;
+        return completion(err);
       }
 
-      if(condval->type != ObjectType::BOOL) {
-        return derr(location(_stmt.condition), "expected a boolean value");
+      if(condval.type() != ObjectType::BOOL) {
+        return completion(derr(location(_stmt.condition), "expected a boolean value"));
       }
 
-      if(!(std::get<Bool>(condval->child).value)) {
+      if(!(condval.as_bool())) {
         break;
       }
     }
 
-    Scope for_body(&for_header);
-    ObjectRef value = block_stmt(_stmt.body, for_body);
-    if(value->type == ObjectType::RETVAL || is_err(value)) {
+    Scope for_body(&for_header, &_stmt.body->layout);
+    Completion value = block_stmt(_stmt.body, for_body);
+    if(value.kind != Completion::NORMAL) {
       return value;
     }
 
     if(_stmt.post != nullptr) {
       ObjectRef res = expr(_stmt.post, for_header);
       if(auto err = derr(ast::location(_stmt.post), res); is_err(err)) {
-        return err;
+        return completion(err);
       }
     }
   }
 
-  return OBJECT_NULL;
+  return done;
 }
 
 ObjectRef
@@ -229,30 +360,30 @@ Eval::func_stmt(ast::FunctionStmt& _stmt, Scope& scp) {
   ObjectRef func = gc::alloc();
   func->type = ObjectType::FUNC;
   func->child = Func{
-    .parameters = std::move(_stmt.parameters),
-    .body = std::move(_stmt.body),
+    .parameters = _stmt.parameters,
+    .body = _stmt.body,
   };
 
-  return scp.set(_stmt.name->value, func);
+  return scp.set(*_stmt.name, func);
 }
 
 ObjectRef
 Eval::extern_stmt(const ast::ExternStmt& stmt, Scope& scp) {
-  if(scp.exists(stmt.funcname->value)) {
+  if(scp.exists(*stmt.funcname)) {
     return derr(stmt.funcname->location, "redefinition of variable");
   }
 
-  if(!scp.exists_any(stmt.libname->value)) {
+  ObjectRef libobj = scp.find(*stmt.libname);
+  if(!libobj) {
     return derr(stmt.libname->location, "undefined identifier");
   }
 
-  ObjectRef libobj = scp.get(stmt.libname->value);
-  if(libobj->type != ObjectType::ELIB) {
+  if(libobj.type() != ObjectType::ELIB) {
     return derr(
       stmt.libname->location,
       std::format(
         "expected a 'external libary' type but got '{}' type",
-        to_string(libobj->type)
+        to_string(libobj.type())
       )
     );
   }
@@ -277,7 +408,7 @@ Eval::extern_stmt(const ast::ExternStmt& stmt, Scope& scp) {
     .rettype = stmt.rettype
   };
 
-  scp.set(stmt.funcname->value, res);
+  scp.set(*stmt.funcname, res);
   return res;
 }
 
@@ -286,19 +417,17 @@ Eval::expr_stmt(const ast::ExprStmt& stmt, Scope& scp) {
   return expr(stmt.expr, scp);
 }
 
-ObjectRef
+Completion
 Eval::block_stmt(const ast::BlockStmtRef& _stmt, Scope& scp) {
-  ObjectRef result = OBJECT_NULL;
-
   for(const auto& s: _stmt->stmts) {
-    result = stmt(s, scp);
+    Completion result = stmt(s, scp);
 
-    if(result->type == ObjectType::RETVAL || is_err(result)) {
+    if(result.kind != Completion::NORMAL) {
       return result;
     }
   }
 
-  return OBJECT_NULL;
+  return Completion{.kind = Completion::NORMAL, .value = OBJECT_NULL};
 }
 
 // =====================================================================
@@ -311,6 +440,73 @@ Eval::block_stmt(const ast::BlockStmtRef& _stmt, Scope& scp) {
 // =====================================================================
 ObjectRef
 Eval::expr(const ast::ExprRef& _expr, Scope& scp) {
+  #ifdef EVAL_THREADED_ENABLE
+    // one indirect jump per node, the table is indexed by ExprType
+    static void* const dispatch[ExprType::__EXPRNODECOUNT__] = {
+      &&do_ident_expr,
+      &&do_null,
+      &&do_integer_lit,
+      &&do_float_lit,
+      &&do_bool_lit,
+      &&do_string_lit,
+      &&do_array_lit,
+      &&do_struct_lit,
+      &&do_unary_expr,
+      &&do_binary_expr,
+      &&do_assignment_expr,
+      &&do_opassignment_expr,
+      &&do_call_expr,
+      &&do_index_expr,
+      &&do_member_expr
+    };
+
+    goto *dispatch[_expr->type];
+
+    do_ident_expr:
+      return ident_expr(unchecked<ast::Identifier>(_expr->child), scp);
+
+    do_integer_lit:
+      return integer_lit(unchecked<ast::IntegerLit>(_expr->child));
+
+    do_float_lit:
+      return float_lit(unchecked<ast::FloatLit>(_expr->child));
+
+    do_bool_lit:
+      return bool_lit(unchecked<ast::BoolLit>(_expr->child));
+
+    do_string_lit:
+      return string_lit(unchecked<ast::StringLit>(_expr->child));
+
+    do_array_lit:
+      return array_lit(unchecked<ast::ArrayLit>(_expr->child), scp);
+
+    do_struct_lit:
+      return struct_lit(unchecked<ast::StructLit>(_expr->child), scp);
+
+    do_unary_expr:
+      return unary_expr(unchecked<ast::UnaryExpr>(_expr->child), scp);
+
+    do_binary_expr:
+      return binary_expr(unchecked<ast::BinaryExpr>(_expr->child), scp);
+
+    do_assignment_expr:
+      return assignment_expr(unchecked<ast::AssignmentExpr>(_expr->child), scp);
+
+    do_opassignment_expr:
+      return opassignment_expr(unchecked<ast::OpAssignmentExpr>(_expr->child), scp);
+
+    do_call_expr:
+      return call_expr(unchecked<ast::CallExpr>(_expr->child), scp);
+
+    do_index_expr:
+      return index_expr(unchecked<ast::IndexExpr>(_expr->child), scp);
+
+    do_member_expr:
+      return member_expr(unchecked<ast::MemberExpr>(_expr->child), scp);
+
+    do_null:
+      return OBJECT_NULL;
+  #else
   switch(_expr->type) {
     case ExprType::NULLLIT:
       return OBJECT_NULL;
@@ -360,42 +556,33 @@ Eval::expr(const ast::ExprRef& _expr, Scope& scp) {
     default:
       return OBJECT_NULL;
   }
+  #endif
 }
 
 static ObjectRef
 unaray_not(const ObjectRef& value) {
-  if(value.get() == OBJECT_TRUE.get()) return OBJECT_FALSE;
-  if(value.get() == OBJECT_FALSE.get()) return OBJECT_TRUE;
-  if(value.get() == OBJECT_NULL.get()) return OBJECT_TRUE;
+  if(value.same(OBJECT_TRUE)) return OBJECT_FALSE;
+  if(value.same(OBJECT_FALSE)) return OBJECT_TRUE;
+  if(value.same(OBJECT_NULL)) return OBJECT_TRUE;
   return OBJECT_FALSE;
 }
 
 static ObjectRef
 unaray_sub(const ObjectRef& value) {
-  ObjectRef result = gc::alloc();
-  result->type = value->type;
-
-  switch(value->type) {
+  switch(value.type()) {
     case ObjectType::INT:
-      result->child = Int{
-        .value = -(std::get<Int>(value->child).value)
+      return Int{
+        .value = -(value.as_int())
       };
-      break;
 
     case ObjectType::FLOAT:
-      result->child = Float{
-        .value = -(std::get<Float>(value->child).value)
+      return Float{
+        .value = -(value.as_float())
       };
-      break;
 
     default:
-      result->type = ObjectType::SERR;
-      result->child = String{
-        .value = "type is not supported"
-      };
+      return serr("type is not supported");
   }
-
-  return result;
 }
 
 ObjectRef
@@ -405,24 +592,25 @@ Eval::unary_expr(const ast::UnaryExpr& _expr, Scope& scp) {
     return err;
   }
 
-  switch(_expr.operator_) {
+  if(_expr.operator_ != Token::NOT && _expr.operator_ != Token::SUB) {
+    return derr(_expr.location, "unknown operator");
+  }
+
+  return derr(ast::location(_expr.right), unary(_expr.operator_, value));
+}
+
+ObjectRef
+unary(Token operator_, const ObjectRef& value) {
+  switch(operator_) {
     case Token::NOT:
-      value = unaray_not(value);
-      break;
+      return unaray_not(value);
 
     case Token::SUB:
-      value = unaray_sub(value);
-      break;
+      return unaray_sub(value);
 
     default:
-      return derr(_expr.location, "unknown operator");
+      return serr("unknown operator");
   }
-
-  if(auto err = derr(ast::location(_expr.right), value); is_err(err)) {
-    return err;
-  }
-
-  return value;
 }
 
 static ObjectRef
@@ -432,7 +620,6 @@ to_bool(bool value) {
 
 static ObjectRef
 binary(Token operator_, const Int& lvalue, const Int& rvalue) {
-  ObjectRef result = gc::alloc();
   int64_t resval = 0;
 
   switch(operator_) {
@@ -471,23 +658,16 @@ binary(Token operator_, const Int& lvalue, const Int& rvalue) {
       return to_bool(lvalue.value != rvalue.value);
 
     default:
-      result->type = ObjectType::SERR;
-      result->child = String{
-        .value = "unknown operator"
-      };
-      return result;
+      return serr("unknown operator");
   }
 
-  result->type = ObjectType::INT;
-  result->child = Int{
+  return Int{
     .value = resval
   };
-  return result;
 }
 
 static ObjectRef
 binary(Token operator_, const Float& lvalue, const Float& rvalue) {
-  ObjectRef result = gc::alloc();
   double resval = 0;
 
   switch(operator_) {
@@ -526,61 +706,46 @@ binary(Token operator_, const Float& lvalue, const Float& rvalue) {
       return to_bool(lvalue.value != rvalue.value);
 
     default:
-      result->type = ObjectType::SERR;
-      result->child = String{
-        .value = "unknown operator"
-      };
-      return result;
+      return serr("unknown operator");
   }
 
-  result->type = ObjectType::FLOAT;
-  result->child = Float{
+  return Float{
     .value = resval
   };
-  return result;
 }
 
 static ObjectRef
 binary(Token operator_, const String& lvalue, const String& rvalue) {
-  ObjectRef result = gc::alloc();
-  std::string resval;
-
+  // comparisons are immediate bools, only a concatenation allocates
   switch(operator_) {
-    case Token::ADD:
-      resval = lvalue.value + rvalue.value;
-      break;
+    case Token::ADD: {
+      ObjectRef result = gc::alloc();
+      result->type = ObjectType::STRING;
+      result->child = String(lvalue.value() + rvalue.value());
+      return result;
+    }
 
     case Token::LES:
-      return to_bool(lvalue.value < rvalue.value);
+      return to_bool(lvalue.value() < rvalue.value());
 
     case Token::LEE:
-      return to_bool(lvalue.value <= rvalue.value);
+      return to_bool(lvalue.value() <= rvalue.value());
 
     case Token::GRT:
-      return to_bool(lvalue.value > rvalue.value);
+      return to_bool(lvalue.value() > rvalue.value());
 
     case Token::GRE:
-      return to_bool(lvalue.value >= rvalue.value);
+      return to_bool(lvalue.value() >= rvalue.value());
 
     case Token::EQL:
-      return to_bool(lvalue.value == rvalue.value);
+      return to_bool(lvalue.value() == rvalue.value());
 
     case Token::NEQL:
-      return to_bool(lvalue.value != rvalue.value);
+      return to_bool(lvalue.value() != rvalue.value());
 
     default:
-      result->type = ObjectType::SERR;
-      result->child = String{
-        .value = "unknown operator"
-      };
-      return result;
+      return serr("unknown operator");
   }
-
-  result->type = ObjectType::STRING;
-  result->child = String{
-    .value = resval
-  };
-  return result;
 }
 
 ObjectRef
@@ -595,88 +760,68 @@ Eval::binary_expr(const ast::BinaryExpr& _expr, Scope& scp) {
     return err;
   }
 
-  if(lvalue->type == ObjectType::INT && rvalue->type == ObjectType::INT) {
-    ObjectRef result = binary(
-      _expr.operator_,
-      std::get<Int>(lvalue->child),
-      std::get<Int>(rvalue->child)
-    );
-
-    if(auto err = derr(_expr.location, result); is_err(result)) {
-      return err;
-    }
+  return derr(_expr.location, binary(_expr.operator_, lvalue, rvalue));
+}
 
-    return result;
+ObjectRef
+binary(Token operator_, const ObjectRef& lvalue, const ObjectRef& rvalue) {
+  if(lvalue.type() == ObjectType::INT && rvalue.type() == ObjectType::INT) {
+    return binary(
+      operator_,
+      Int{.value = lvalue.as_int()},
+      Int{.value = rvalue.as_int()}
+    );
   }
 
-  if(lvalue->type == ObjectType::FLOAT && rvalue->type == ObjectType::FLOAT) {
-    ObjectRef result = binary(
-      _expr.operator_,
-      std::get<Float>(lvalue->child),
-      std::get<Float>(rvalue->child)
+  if(lvalue.type() == ObjectType::FLOAT && rvalue.type() == ObjectType::FLOAT) {
+    return binary(
+      operator_,
+      Float{.value = lvalue.as_float()},
+      Float{.value = rvalue.as_float()}
     );
-
-    if(auto err = derr(_expr.location, result); is_err(result)) {
-      return err;
-    }
-
-    return result;
   }
 
-  if(lvalue->type == ObjectType::STRING && rvalue->type == ObjectType::STRING) {
-    ObjectRef result = binary(
-      _expr.operator_,
+  if(lvalue.type() == ObjectType::STRING && rvalue.type() == ObjectType::STRING) {
+    return binary(
+      operator_,
       std::get<String>(lvalue->child),
       std::get<String>(rvalue->child)
     );
-
-    if(auto err = derr(_expr.location, result); is_err(result)) {
-      return err;
-    }
-
-    return result;
   }
 
-  if(lvalue->type != rvalue->type) {
-    return derr(
-      _expr.location,
+  if(lvalue.type() != rvalue.type()) {
+    return serr(
       std::format(
         "type mismatch between '{}' and '{}'",
-        to_string(lvalue->type),
-        to_string(rvalue->type)
+        to_string(lvalue.type()),
+        to_string(rvalue.type())
       )
     );
   }
 
-  if(_expr.operator_ == Token::EQL) {
-    return to_bool(lvalue.get() == rvalue.get());
+  if(operator_ == Token::EQL) {
+    return to_bool(lvalue.same(rvalue));
   }
 
-  if(_expr.operator_ == Token::NEQL) {
-    return to_bool(lvalue.get() != rvalue.get());
+  if(operator_ == Token::NEQL) {
+    return to_bool(!lvalue.same(rvalue));
   }
 
-  return derr(_expr.location, "unknown operator");
+  return serr("unknown operator");
 }
 
 ObjectRef
 Eval::integer_lit(const ast::IntegerLit& i) {
-  ObjectRef obj = gc::alloc();
-  obj->type = ObjectType::INT;
-  obj->child = Int{
+  return Int{
     .value = i.value
   };
-  return obj;
 }
 
 ObjectRef
 Eval::float_lit(const ast::FloatLit& f) {
-  ObjectRef obj = gc::alloc();
-  obj->type = ObjectType::FLOAT;
-  obj->child = Float{
+  return Float{
     .value = f.value
   };
-  return obj;
 }
 
 ObjectRef
@@ -688,9 +833,7 @@ ObjectRef
 Eval::string_lit(const ast::StringLit& s) {
   ObjectRef obj = gc::alloc();
   obj->type = ObjectType::STRING;
-  obj->child = String{
-    .value = s.value
-  };
+  obj->child = String(s.value);
   return obj;
 }
 
@@ -707,23 +850,22 @@ Eval::array_lit(const ast::ArrayLit& a, Scope& scp) {
 
   ObjectRef array = gc::alloc();
   array->type = ObjectType::ARRAY;
-  array->child = Array{
-    .elements = elements
-  };
+  array->child = Array(std::move(elements));
   return array;
 }
 
 ObjectRef
 Eval::struct_lit(const ast::StructLit& s, Scope& scp) {
   ObjectRef obj = expr(s.name, scp);
-  if(obj->type != ObjectType::STRUCT) {
+  if(obj.type() != ObjectType::STRUCT) {
     return derr(ast::location(s.name), "expected 'struct' type");
   }
 
   const Struct& struct_obj = std::get<Struct>(obj->child);
-  std::map<std::string, ObjectRef> fields;
+  std::vector<ObjectRef> fields(struct_obj.fields.size());
   for(size_t i = 0; i < s.names.size(); i++) {
-    if(!struct_obj.fields.contains(s.names[i]->value)) {
+    size_t slot = struct_obj.slot(s.names[i]->value);
+    if(slot == Struct::NONE) {
       return derr(
         s.names[i]->location,
         std::format(
@@ -739,29 +881,29 @@ Eval::struct_lit(const ast::StructLit& s, Scope& scp) {
       return err;
     }
 
-    std::string type_name = to_string(val->type);
-    if(val->type == ObjectType::STRUCTVAL) {
+    std::string type_name = to_string(val.type());
+    if(val.type() == ObjectType::STRUCTVAL) {
       type_name = std::get<Struct>(std::get<StructVal>(val->child).parent->child).name;
     }
 
-    if(struct_obj.fields.at(s.names[i]->value) != type_name) {
+    if(struct_obj.types[slot] != type_name) {
       return derr(
         s.names[i]->location,
         std::format(
           "expected type '{}' but got '{}'",
-          struct_obj.fields.at(s.names[i]->value),
+          struct_obj.types[slot],
           type_name
         )
       );
     }
 
-    fields[s.names[i]->value] = val;
+    fields[slot] = val;
   }
 
   std::vector<std::string> uninit_f;
-  for(const auto& [k, v]: struct_obj.fields) {
-    if(!fields.contains(k)) {
-      uninit_f.push_back(k);
+  for(size_t i = 0; i < fields.size(); i++) {
+    if(!fields[i]) {
+      uninit_f.push_back(struct_obj.fields[i]);
     }
   }
 
@@ -786,15 +928,15 @@ Eval::struct_lit(const ast::StructLit& s, Scope& scp) {
   res->type = ObjectType::STRUCTVAL;
   res->child = StructVal{
     .parent = obj,
-    .fields = fields
+    .fields = std::move(fields)
   };
   return res;
 }
 
 ObjectRef
 Eval::ident_expr(const ast::Identifier& ident, Scope& scp) {
-  if(scp.exists_any(ident.value)) {
-    return scp.get(ident.value);
+  if(ObjectRef obj = scp.find(ident); obj) {
+    return obj;
   }
 
   if(builtinfns.contains(ident.value)) {
@@ -804,15 +946,34 @@ Eval::ident_expr(const ast::Identifier& ident, Scope& scp) {
   return derr(ident.location, "undefined identifier");
 }
 
+// slot of the member's field in the value, the name is only looked up
+// when the struct differs from the one last seen at this member
+static size_t
+member_slot(const ast::MemberExpr& _expr, const StructVal& sv) {
+  const Struct& s = std::get<Struct>(sv.parent->child);
+  if(_expr.shape != s.shape) {
+    size_t slot = s.slot(_expr.field->value);
+    if(slot == Struct::NONE) {
+      return slot;
+    }
+
+    _expr.shape = s.shape;
+    _expr.slot = slot;
+  }
+
+  return _expr.slot;
+}
+
 ObjectRef
 Eval::assignment_member(const ast::MemberExpr& _expr, const ast::ExprRef& right, Scope& scp) {
   ObjectRef obj = expr(_expr.left, scp);
-  if(obj->type != ObjectType::STRUCTVAL) {
+  if(obj.type() != ObjectType::STRUCTVAL) {
     return derr(ast::location(_expr.left), "expected a 'struct' instance type");
   }
 
   StructVal& sv = std::get<StructVal>(obj->child);
-  if(!sv.fields.contains(_expr.field->value)) {
+  size_t slot = member_slot(_expr, sv);
+  if(slot == Struct::NONE) {
     return derr(
       _expr.field->location,
       std::format(
@@ -824,18 +985,18 @@ Eval::assignment_member(const ast::MemberExpr& _expr, const ast::ExprRef& right,
   }
 
   ObjectRef val = expr(right, scp);
-  if(val->type != sv.fields.at(_expr.field->value)->type) {
+  if(val.type() != sv.fields[slot].type()) {
     return derr(
       _expr.field->location,
       std::format(
         "expected type '{}' but got '{}'",
-        to_string(sv.fields.at(_expr.field->value)->type),
-        to_string(val->type)
+        to_string(sv.fields[slot].type()),
+        to_string(val.type())
       )
     );
   }
 
-  sv.fields[_expr.field->value] = val;
+  sv.fields[slot] = val;
   return obj;
 }
 
@@ -843,18 +1004,18 @@ ObjectRef
 Eval::assignment_ident(const ast::Identifier& ident,
   const ast::ExprRef& right,
   Scope& scp) {
-  if(!scp.exists_any(ident.value)) {
+  ObjectRef obj = scp.find(ident);
+  if(!obj) {
     return derr(ident.location, "undefined identifier");
   }
 
-  ObjectRef obj = scp.get(ident.value);
-  if(obj->type != ObjectType::NULL_ && obj->type == ObjectType::ELIB) {
+  if(obj.type() != ObjectType::NULL_ && obj.type() == ObjectType::ELIB) {
     return derr(ident.location, "a 'library' type variable cannot be reassigned");
   }
 
-  if(obj->type == ObjectType::BFUNC ||
-    obj->type == ObjectType::FUNC ||
-    obj->type == ObjectType::EFUNC) {
+  if(obj.type() == ObjectType::BFUNC ||
+    obj.type() == ObjectType::FUNC ||
+    obj.type() == ObjectType::EFUNC) {
     return derr(ident.location, "a 'function' type variable cannot be reassigned");
   }
 
@@ -863,18 +1024,18 @@ Eval::assignment_ident(const ast::Identifier& ident,
     return err;
   }
 
-  if(obj->type != ObjectType::NULL_ && value->type != obj->type) {
+  if(obj.type() != ObjectType::NULL_ && value.type() != obj.type()) {
     return derr(
       ident.location,
       std::format(
         "value of type '{}' cannot be assigned to a variable type of '{}'",
-        to_string(value->type),
-        to_string(obj->type)
+        to_string(value.type()),
+        to_string(obj.type())
       )
     );
   }
 
-  return scp.update(ident.value, value);
+  return scp.update(ident, value);
 }
 
 ObjectRef
@@ -889,12 +1050,12 @@ Eval::assignment_array(ObjectRef& obj,
     return err;
   }
 
-  if(idx->type != ObjectType::INT) {
+  if(idx.type() != ObjectType::INT) {
     return derr(ast::location(index), "expected a 'int' type");
   }
 
-  int64_t i = std::get<Int>(idx->child).value;
-  if(i < 0 || i >= static_cast<int64_t>(a.elements.size())) {
+  int64_t i = idx.as_int();
+  if(i < 0 || i >= static_cast<int64_t>(a.size())) {
     return derr(ast::location(index), "index out of range");
   }
 
@@ -903,7 +1064,7 @@ Eval::assignment_array(ObjectRef& obj,
     return err;
   }
 
-  a.elements[i] = value;
+  a.set(i, value);
   return obj;
 }
 
@@ -920,12 +1081,12 @@ Eval::assignment_string(
     return err;
   }
 
-  if(idx->type != ObjectType::INT) {
+  if(idx.type() != ObjectType::INT) {
     return derr(ast::location(index), "expected a 'int' type");
   }
 
-  int64_t i = std::get<Int>(idx->child).value;
-  if(i < 0 || i >= static_cast<int64_t>(s.value.length())) {
+  int64_t i = idx.as_int();
+  if(i < 0 || i >= static_cast<int64_t>(s.value().length())) {
     return derr(ast::location(index), "index out of range");
   }
 
@@ -934,21 +1095,21 @@ Eval::assignment_string(
     return err;
   }
 
-  if(value->type != ObjectType::STRING) {
+  if(value.type() != ObjectType::STRING) {
     return derr(
       ast::location(right),
-      std::format("type '{}' cannot be assigned to a string", to_string(value->type))
+      std::format("type '{}' cannot be assigned to a string", to_string(value.type()))
     );
   }
 
-  if(std::get<String>(value->child).value.length() != 1) {
+  if(std::get<String>(value->child).value().length() != 1) {
     return derr(
       ast::location(right),
       "expected a string with length of '1'"
     );
   }
 
-  s.value[i] = std::get<String>(value->child).value[0];
+  s.mutable_value()[i] = std::get<String>(value->child).value()[0];
   return obj;
 }
 
@@ -976,11 +1137,11 @@ Eval::assignment_expr(const ast::AssignmentExpr& _expr, Scope& scp) {
         return err;
       }
 
-      if(left->type != ObjectType::ARRAY && left->type != ObjectType::STRING) {
+      if(left.type() != ObjectType::ARRAY && left.type() != ObjectType::STRING) {
         return derr(ast::location(idxexpr.left), "type cannot be indexed");
       }
 
-      switch(left->type) {
+      switch(left.type()) {
         case ObjectType::ARRAY:
           return assignment_array(
             left,
@@ -1019,34 +1180,31 @@ Eval::opassignment_expr(ast::OpAssignmentExpr& _expr, Scope& scp) {
   ast::BinaryExpr bin_expr = {
     .location = _expr.location,
     .operator_ = _expr.operator_,
-    .left = std::move(_expr.left),
-    .right = std::move(_expr.right)
+    .left = _expr.left,
+    .right = _expr.right
   };
 
   ObjectRef value = binary_expr(bin_expr, scp);
 
-  _expr.left = std::move(bin_expr.left);
-  _expr.right = std::move(bin_expr.right);
-
   if(is_err(value)) {
     return value;
   }
 
   const auto& ident = std::get<ast::Identifier>(_expr.left->child);
-  ObjectRef obj = scp.get(ident.value);
+  ObjectRef obj = scp.find(ident);
 
-  if(obj->type != value->type) {
+  if(obj.type() != value.type()) {
     return derr(
       _expr.location,
       std::format(
         "type mismatch between '{}' and '{}'",
-        to_string(obj->type),
-        to_string(value->type)
+        to_string(obj.type()),
+        to_string(value.type())
       )
     );
   }
 
-  return scp.update(ident.value, value);
+  return scp.update(ident, value);
 }
 
 ObjectRef
@@ -1061,35 +1219,32 @@ Eval::index_expr(const ast::IndexExpr& _expr, Scope& scp) {
     return err;
   }
 
-  if(idx->type != ObjectType::INT) {
+  if(idx.type() != ObjectType::INT) {
     return derr(_expr.location, "expected an 'int' type");
   }
 
-  int64_t i = std::get<Int>(idx->child).value;
+  int64_t i = idx.as_int();
 
-  switch(obj->type) {
+  switch(obj.type()) {
     case ObjectType::STRING: {
-      const std::string& str = std::get<String>(obj->child).value;
+      const std::string& str = std::get<String>(obj->child).value();
       if(i < 0 || i >= static_cast<int64_t>(str.length())) {
         return derr(ast::location(_expr.index), "index out of range");
       }
 
       ObjectRef value = gc::alloc();
       value->type = ObjectType::STRING;
-      value->child = String{
-        .value = std::string{str[i]}
-      };
+      value->child = String(std::string{str[i]});
       return value;
     }
 
     case ObjectType::ARRAY: {
-      const auto arr = std::get<Array>(obj->child).elements;
+      const Array& arr = std::get<Array>(obj->child);
       if(i < 0 || i >= static_cast<int64_t>(arr.size())) {
         return derr(ast::location(_expr.index), "index out of range");
       }
 
-      ObjectRef value = gc::alloc();
-      return arr[i];
+      return arr.at(i);
     }
 
     default:
@@ -1115,17 +1270,54 @@ Eval::func(
     );
   }
 
-  Scope func_scope(&scp);
+  Scope func_scope(&scp, &_func.body->layout);
   for(size_t i = 0; i < params.size(); i++) {
     ObjectRef value = expr(params[i], scp);
     if(auto err = derr(ast::location(params[i]), value); is_err(err)) {
       return err;
     }
 
-    func_scope.set(_func.parameters[i]->value, value);
+    func_scope.set(*_func.parameters[i], value);
   }
 
-  return block_stmt(_func.body, func_scope);
+  if(!enter(loc)) {
+    return overflow(lexer, loc, calls);
+  }
+
+  ast::BlockStmtRef caller = running;
+  running = _func.body;
+
+  Completion res = block_stmt(_func.body, func_scope);
+  while(res.kind == Completion::TAILCALL) {
+    rebind(_func, func_scope);
+    res = block_stmt(_func.body, func_scope);
+  }
+
+  running = caller;
+  calls.pop_back();
+  // the returned value, the error or null when the body ran to its end
+  return res.value;
+}
+
+// enter() and rebind() stay out of func(), every byte of its frame is
+// paid once per nested call on the native stack
+bool
+Eval::enter(const Location& loc) {
+  uintptr_t sp = reinterpret_cast<uintptr_t>(__builtin_frame_address(0));
+  if(calls.size() == max_stack || sp < stack_end) {
+    return false;
+  }
+
+  calls.push_back(loc);
+  return true;
+}
+
+void
+Eval::rebind(const Func& _func, Scope& func_scope) {
+  for(size_t i = 0; i < tailargs.size(); i++) {
+    func_scope.set(*_func.parameters[i], tailargs[i]);
+  }
+  tailargs.clear();
 }
 
 ObjectRef
@@ -1175,24 +1367,31 @@ object_to_ffi_type(ObjectType t) {
 };
 
 static void*
-object_to_data_ptr(ObjectRef& obj) {
-  switch(obj->type) {
-    case ObjectType::INT: return &(std::get<Int>(obj->child).value);
-    case ObjectType::FLOAT: return &(std::get<Float>(obj->child).value);
-    case ObjectType::BOOL: return &(std::get<Bool>(obj->child).value);
-    case ObjectType::STRING: return (void*)(std::get<String>(obj->child).value.c_str());
+object_to_data_ptr(const ObjectRef& obj, CValue& data) {
+  switch(obj.type()) {
+    case ObjectType::INT: data.i = obj.as_int(); return &data.i;
+    case ObjectType::FLOAT: data.f = obj.as_float(); return &data.f;
+    case ObjectType::BOOL: data.i = obj.as_bool(); return &data.i;
+    case ObjectType::STRING:
+      data.s = (char*)(std::get<String>(obj->child).value().c_str());
+      return &data.s;
     default: return nullptr;
   }
 };
 
-static void
-object_set_child(ObjectRef& obj) {
-  switch(obj->type) {
-    case ObjectType::INT: obj->child = Int{}; break;
-    case ObjectType::FLOAT: obj->child = Float{}; break;
-    case ObjectType::BOOL: obj->child = Bool{}; break;
-    case ObjectType::STRING: obj->child = String{}; break;
-    default: obj->child = Null{}; break;
+static ObjectRef
+data_to_object(ObjectType type, const CValue& data) {
+  switch(type) {
+    case ObjectType::INT: return Int{.value = data.i};
+    case ObjectType::FLOAT: return Float{.value = data.f};
+    case ObjectType::BOOL: return to_bool((int)data.i != 0);
+    case ObjectType::STRING: {
+      ObjectRef res = gc::alloc();
+      res->type = ObjectType::STRING;
+      res->child = String(data.s);
+      return res;
+    }
+    default: return OBJECT_NULL;
   }
 };
 
@@ -1203,71 +1402,87 @@ Eval::efunc(
   const std::vector<ast::ExprRef>& params,
   Scope& scp
 ) {
-  bool is_variadic = false;
+  if(auto err = derr(loc, efunc_arity(_func, params.size())); is_err(err)) {
+    return err;
+  }
+
+  std::vector<ObjectRef> args;
+  for(size_t i = 0; i < params.size(); i++) {
+    ObjectRef obj = expr(params[i], scp);
+    if(auto err = derr(ast::location(params[i]), obj); is_err(err)) {
+      return err;
+    }
+
+    if(auto err = derr(ast::location(params[i]), efunc_arg(_func, i, obj)); is_err(err)) {
+      return err;
+    }
+
+    args.push_back(obj);
+  }
 
+  return derr(loc, efunc_call(_func, args));
+}
+
+ObjectRef
+efunc_arity(const EFunc& _func, size_t argc) {
   if(_func.argstypes.size() > 0 && _func.argstypes.back() == Token::VARIADIC) {
-    is_variadic = true;
-    if(params.size() < _func.argstypes.size() - 1) {
-      return derr(
-        loc,
+    if(argc < _func.argstypes.size() - 1) {
+      return serr(
         std::format(
           "function takes atleast {} arguments but {} were given",
           _func.argstypes.size() - 1,
-          params.size()
+          argc
         )
       );
     }
-  } else if(_func.argstypes.size() != params.size()) {
-    return derr(
-      loc,
+  } else if(_func.argstypes.size() != argc) {
+    return serr(
       std::format(
         "function takes {} arguments but {} were given",
         _func.argstypes.size(),
-        params.size()
+        argc
       )
     );
   }
 
-  std::vector<ObjectRef> objs;
-  std::vector<ffi_type*> ffi_types;
-  std::vector<void*> c_ptr_value;
-  std::vector<char*> char_ref_handler;
+  return OBJECT_NULL;
+}
 
-  for(size_t i = 0; i < params.size(); i++) {
-    ObjectRef obj = expr(params[i], scp);
-    if(auto err = derr(ast::location(params[i]), obj); is_err(err)) {
-      return err;
-    }
+ObjectRef
+efunc_arg(const EFunc& _func, size_t i, const ObjectRef& obj) {
+  bool is_variadic = _func.argstypes.size() > 0 && _func.argstypes.back() == Token::VARIADIC;
 
-    if(obj->type == ObjectType::STRUCTVAL) {
-      return derr(
-        ast::location(params[i]),
-        "passing 'struct' type to external function is not implemented yet"
+  if(obj.type() == ObjectType::STRUCTVAL) {
+    return serr("passing 'struct' type to external function is not implemented yet");
+  }
+
+  if(!is_variadic || (is_variadic && _func.argstypes.size() - 1 > i)) {
+    if(token_to_object_type(_func.argstypes[i]) != obj.type()) {
+      return serr(
+        std::format(
+          "expected '{}' type but got '{}' type",
+          to_string(token_to_object_type(_func.argstypes[i])),
+          to_string(obj.type())
+        )
       );
     }
+  }
 
-    if(!is_variadic || (is_variadic && _func.argstypes.size() - 1 > i)) {
-      if(token_to_object_type(_func.argstypes[i]) != obj->type) {
-        return derr(
-          ast::location(params[i]),
-          std::format(
-            "expected '{}' type but got '{}' type",
-            to_string(token_to_object_type(_func.argstypes[i])),
-            to_string(obj->type)
-          )
-        );
-      }
-    }
+  return OBJECT_NULL;
+}
 
-    objs.push_back(obj);
-    ffi_types.push_back(object_to_ffi_type(obj->type));
-    if(obj->type == ObjectType::STRING) {
-      char_ref_handler.push_back((char*)object_to_data_ptr(obj));
-      c_ptr_value.push_back(&char_ref_handler.back());
-      continue;
-    }
+ObjectRef
+efunc_call(const EFunc& _func, std::vector<ObjectRef>& args) {
+  bool is_variadic = _func.argstypes.size() > 0 && _func.argstypes.back() == Token::VARIADIC;
 
-    c_ptr_value.push_back(object_to_data_ptr(obj));
+  std::vector<ffi_type*> ffi_types;
+  std::vector<void*> c_ptr_value;
+  // c_ptr_value keeps pointers into c_values
+  std::vector<CValue> c_values(args.size());
+
+  for(size_t i = 0; i < args.size(); i++) {
+    ffi_types.push_back(object_to_ffi_type(args[i].type()));
+    c_ptr_value.push_back(object_to_data_ptr(args[i], c_values[i]));
   }
 
   ffi_status status;
@@ -1278,7 +1493,7 @@ Eval::efunc(
       &cif,
       FFI_DEFAULT_ABI,
       _func.argstypes.size() - 1,
-      params.size(),
+      args.size(),
       ret_type,
       ffi_types.data()
     );
@@ -1286,50 +1501,31 @@ Eval::efunc(
     status = ffi_prep_cif(
       &cif,
       FFI_DEFAULT_ABI,
-      params.size(),
+      args.size(),
       ret_type,
       ffi_types.data()
     );
   }
 
   if(status != FFI_OK) {
-    return derr(loc, "failed to ffi_prep_cif");
-  }
-
-  char* ret_str = nullptr;
-  void* ret_val = nullptr;
-  ObjectRef res = gc::alloc();
-
-  res->type = token_to_object_type(_func.rettype);
-  if(res->type == ObjectType::STRING) {
-    ret_val = &ret_str;
-  } else {
-    object_set_child(res);
-    ret_val = object_to_data_ptr(res);
+    return serr("failed to ffi_prep_cif");
   }
 
-  ffi_call(&cif, FFI_FN(_func.func), ret_val, c_ptr_value.data());
+  CValue ret_val = {.i = 0};
+  ffi_call(&cif, FFI_FN(_func.func), &ret_val, c_ptr_value.data());
 
-  if(res->type == ObjectType::BOOL) {
-    res = std::get<Bool>(res->child).value ? OBJECT_TRUE : OBJECT_FALSE;
-  } else if(res->type == ObjectType::STRING) {
-    res->child = String{
-      .value = ret_str
-    };
-  }
-
-  return res;
+  return data_to_object(token_to_object_type(_func.rettype), ret_val);
 }
 
 ObjectRef
-Eval::call_expr(const ast::CallExpr& _expr, Scope& scp) {
-  ObjectRef funcobj = expr(_expr.function, scp);
+Eval::call_expr(const ast::CallExpr& _expr, Scope& scp, const ObjectRef* callee) {
+  ObjectRef funcobj = callee != nullptr ? *callee : expr(_expr.function, scp);
   if(auto err = derr(ast::location(_expr.function), funcobj); is_err(err)) {
     return err;
   }
 
   ObjectRef retval = OBJECT_NULL;
-  switch(funcobj->type) {
+  switch(funcobj.type()) {
     case ObjectType::FUNC:
       retval = func(
         std::get<Func>(funcobj->child),
@@ -1361,22 +1557,19 @@ Eval::call_expr(const ast::CallExpr& _expr, Scope& scp) {
       return derr(location(_expr.function), "not a function");
   }
 
-  if(retval->type == ObjectType::RETVAL) {
-    retval = std::get<RetVal>(retval->child).value;
-  }
-
   return retval;
 }
 
 ObjectRef
 Eval::member_expr(const ast::MemberExpr& _expr, Scope& scp) {
   ObjectRef obj = expr(_expr.left, scp);
-  if(obj->type != ObjectType::STRUCTVAL) {
+  if(obj.type() != ObjectType::STRUCTVAL) {
     return derr(ast::location(_expr.left), "expected a 'struct' instance type");
   }
 
   const StructVal& s = std::get<StructVal>(obj->child);
-  if(!s.fields.contains(_expr.field->value)) {
+  size_t slot = member_slot(_expr, s);
+  if(slot == Struct::NONE) {
     return derr(
       _expr.field->location,
       std::format(
@@ -1387,21 +1580,61 @@ Eval::member_expr(const ast::MemberExpr& _expr, Scope& scp) {
     );
   }
 
-  return s.fields.at(_expr.field->value);
+  return s.fields[slot];
 }
 
 bool
 Eval::is_err(const ObjectRef& obj) {
-  return (obj) && (obj->type == SERR || obj->type == DERR);
+  return (obj) && (obj.type() == SERR || obj.type() == DERR);
+}
+
+Completion
+Eval::completion(const ObjectRef& value) {
+  return Completion{
+    .kind = is_err(value) ? Completion::ERROR : Completion::NORMAL,
+    .value = value
+  };
 }
 
 ObjectRef
 serr(const std::string& err_msg) {
   ObjectRef err = gc::alloc();
   err->type = ObjectType::SERR;
-  err->child = String{
-    .value = err_msg
-  };
+  err->child = String(err_msg);
+  return err;
+}
+
+ObjectRef
+overflow(Lexer& lexer, const Location& loc, const std::vector<Location>& calls) {
+  std::string msg = lexer.fmt_error(
+    loc,
+    std::format("stack overflow, more than {} nested calls", calls.size())
+  );
+  msg += "\ncall trace, innermost first:";
+
+  // a recursion repeats the same call site, every run of one is a line
+  constexpr size_t TRACE_LINES = 16;
+  size_t end = calls.size();
+  for(size_t line = 0; end > 0 && line < TRACE_LINES; line++) {
+    size_t begin = end - 1;
+    while(begin > 0 && calls[begin - 1].offset == calls[end - 1].offset) {
+      begin--;
+    }
+
+    msg += std::format("\n  at {}", lexer.fmt_location(calls[end - 1]));
+    if(end - begin > 1) {
+      msg += std::format(" ({} times)", end - begin);
+    }
+    end = begin;
+  }
+
+  if(end > 0) {
+    msg += std::format("\n  ... {} more calls", end);
+  }
+
+  ObjectRef err = gc::alloc();
+  err->type = ObjectType::DERR;
+  err->child = String(msg);
   return err;
 }
 
@@ -1411,19 +1644,17 @@ Eval::derr(const Location& loc, const ObjectRef& obj) {
     return obj;
   }
 
-  if(obj->type == ObjectType::DERR) {
+  if(obj.type() == ObjectType::DERR) {
     return obj;
   }
 
-  return derr(loc, std::get<String>(obj->child).value);
+  return derr(loc, std::get<String>(obj->child).value());
 }
 
 ObjectRef
 Eval::derr(const Location& loc, const std::string& err_msg) {
   ObjectRef err = gc::alloc();
   err->type = ObjectType::DERR;
-  err->child = String {
-    .value = lexer.fmt_error(loc, err_msg)
-  };
+  err->child = String(lexer.fmt_error(loc, err_msg));
   return err;
 }
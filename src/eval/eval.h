@@ -13,26 +13,57 @@
 #include <lexer.h>
 #include <object.h>
 #include <scope.h>
+#include <token.h>
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 
 ObjectRef serr(const std::string&);
+ObjectRef unary(token::Token, const ObjectRef&);
+ObjectRef binary(token::Token, const ObjectRef&, const ObjectRef&);
+ObjectRef efunc_arity(const EFunc&, size_t);
+ObjectRef efunc_arg(const EFunc&, size_t, const ObjectRef&);
+ObjectRef efunc_call(const EFunc&, std::vector<ObjectRef>&);
+
+// the stack overflow error of the call at loc, calls holds where every
+// call still running was made, outermost first
+ObjectRef overflow(Lexer&, const Location&, const std::vector<Location>&);
+
+// how a statement finished. NORMAL carries the statement's value on to
+// the next one, RETURN unwinds to the enclosing call with the returned
+// value, TAILCALL unwinds to it to run its body again with new arguments
+// and ERROR unwinds to evaluate() with the error object
+struct Completion {
+  enum Kind {
+    NORMAL = 0,
+    RETURN,
+    TAILCALL,
+    ERROR,
+  };
+
+  Kind kind;
+  ObjectRef value;
+};
 
 class Eval {
 public:
-  Eval(Lexer&);
+  // calls nest on the native stack, a call that would leave too little
+  // of it or that nests more than max_stack (when not zero) calls fails
+  // with a stack overflow
+  Eval(Lexer&, size_t max_stack = 0);
   ObjectRef evaluate(const ast::ProgramRef&, Scope&);
 
 private:
-  ObjectRef stmt(const ast::StmtRef&, Scope&);
+  Completion stmt(const ast::StmtRef&, Scope&);
   ObjectRef struct_stmt(ast::StructStmt&, Scope&);
   ObjectRef let_stmt(const ast::LetStmt&, Scope&);
-  ObjectRef return_stmt(const ast::ReturnStmt&, Scope&);
-  ObjectRef if_stmt(const ast::IfStmt&, Scope&);
-  ObjectRef for_stmt(const ast::ForStmt&, Scope&);
+  Completion return_stmt(const ast::ReturnStmt&, Scope&);
+  Completion if_stmt(const ast::IfStmt&, Scope&);
+  Completion for_stmt(const ast::ForStmt&, Scope&);
   ObjectRef func_stmt(ast::FunctionStmt&, Scope&);
   ObjectRef extern_stmt(const ast::ExternStmt&, Scope&);
   ObjectRef expr_stmt(const ast::ExprStmt&, Scope&);
-  ObjectRef block_stmt(const ast::BlockStmtRef&, Scope&);
+  Completion block_stmt(const ast::BlockStmtRef&, Scope&);
 
   ObjectRef expr(const ast::ExprRef&, Scope&);
   ObjectRef unary_expr(const ast::UnaryExpr&, Scope&);
@@ -53,18 +84,34 @@ private:
   ObjectRef assignment_expr(const ast::AssignmentExpr&, Scope&);
   ObjectRef opassignment_expr(ast::OpAssignmentExpr&, Scope&);
   ObjectRef index_expr(const ast::IndexExpr&, Scope&);
-  ObjectRef call_expr(const ast::CallExpr&, Scope&);
+  // callee is the function expression when it was evaluated already
+  ObjectRef call_expr(const ast::CallExpr&, Scope&, const ObjectRef* callee = nullptr);
+  Completion tail_call(const ast::ReturnStmt&, Scope&);
   ObjectRef member_expr(const ast::MemberExpr&, Scope&);
 
   ObjectRef func(const Func&, const Location&, const std::vector<ast::ExprRef>&, Scope&);
+  // records a call made at loc, false when it would nest too deep
+  bool enter(const Location&);
+  // binds the arguments of a tail call to the parameters
+  void rebind(const Func&, Scope&);
   ObjectRef bfunc(const BFunc&, const Location&, const std::vector<ast::ExprRef>&, Scope&);
   ObjectRef efunc(const EFunc&, const Location&, const std::vector<ast::ExprRef>&, Scope&);
 
   bool is_err(const ObjectRef&);
+  Completion completion(const ObjectRef&);
   ObjectRef derr(const Location&, const ObjectRef&);
   ObjectRef derr(const Location&, const std::string&);
 
   Lexer& lexer;
+  // body of the innermost running function and the arguments of the
+  // tail call it is about to repeat itself with
+  ast::BlockStmtRef running = nullptr;
+  std::vector<ObjectRef> tailargs;
+  // where each running function was called, for the stack overflow
+  std::vector<Location> calls;
+  size_t max_stack;
+  // lowest address the native stack may reach before a call
+  uintptr_t stack_end;
 };
 
 #endif
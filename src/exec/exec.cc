@@ -1,3 +1,6 @@
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
 #include <cstdio>
 #include <gc.h>
 #include <object.h>
@@ -6,52 +9,260 @@
 #include <ast.h>
 #include <cassert>
 #include <parser.h>
+#include <optimizer.h>
+#include <resolver.h>
+#include <cache.h>
 #include <lexer.h>
 #include <exec.h>
-#include <fstream>
+#include <compiler.h>
+#include <bytecode.h>
+#include <vm.h>
 #include <print>
-#include <sstream>
-#include <cassert>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+
+// the text of a script, regular files are mapped and anything else
+// (a pipe, a terminal, '-' for stdin) is read into a buffer
+class Source {
+public:
+  Source() = default;
+  Source(const Source&) = delete;
+  Source& operator=(const Source&) = delete;
+  ~Source();
+
+  bool open(const char* filename);
+  std::string_view data() const;
+
+private:
+  bool read_all(int fd);
+
+  void* map = nullptr;
+  size_t size = 0;
+  std::string buffer;
+};
+
+Source::~Source() {
+  if(map != nullptr) {
+    munmap(map, size);
+  }
+}
+
+bool
+Source::open(const char* filename) {
+  bool is_stdin = filename == std::string_view("-");
+  int fd = is_stdin ? STDIN_FILENO : ::open(filename, O_RDONLY);
+  if(fd < 0) {
+    return false;
+  }
+
+  struct stat st;
+  bool ok = fstat(fd, &st) == 0;
+  if(ok && S_ISREG(st.st_mode) && st.st_size > 0) {
+    size = st.st_size;
+    map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(map == MAP_FAILED) {
+      map = nullptr;
+      size = 0;
+    } else {
+      // the lexer reads straight through
+      madvise(map, size, MADV_SEQUENTIAL);
+    }
+  }
+
+  if(ok && map == nullptr) {
+    ok = read_all(fd);
+  }
+
+  if(!is_stdin) {
+    close(fd);
+  }
+  return ok;
+}
+
+bool
+Source::read_all(int fd) {
+  char chunk[64 * 1024];
+  while(true) {
+    ssize_t n = read(fd, chunk, sizeof(chunk));
+    if(n == 0) {
+      return true;
+    }
+
+    if(n < 0) {
+      if(errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    buffer.append(chunk, n);
+  }
+}
+
+std::string_view
+Source::data() const {
+  if(map != nullptr) {
+    return std::string_view(static_cast<const char*>(map), size);
+  }
+  return buffer;
+}
+
+static void
+print_stats(const char* filename, Engine engine, std::chrono::steady_clock::time_point start) {
+  auto end = std::chrono::steady_clock::now();
+  double wall_ms = std::chrono::duration<double, std::milli>(end - start).count();
+  gc::Stats stats = gc::stats();
+
+  // ru_maxrss is in kilobytes on linux and in bytes on darwin
+  struct rusage usage = {};
+  getrusage(RUSAGE_SELF, &usage);
+  #ifdef __APPLE__
+    long peak_rss_kb = usage.ru_maxrss / 1024;
+  #else
+    long peak_rss_kb = usage.ru_maxrss;
+  #endif
+
+  std::string file;
+  for(const char* c = filename; *c != '\0'; c++) {
+    if(*c == '"' || *c == '\\') {
+      file += '\\';
+    }
+    file += *c;
+  }
+
+  fflush(stdout);
+  std::println(
+    stderr,
+    "{{\"file\": \"{}\", \"engine\": \"{}\", \"wall_ms\": {:.3f}, \"allocs\": {}, "
+    "\"frees\": {}, \"collections\": {}, \"peak_objects\": {}, \"peak_rss_kb\": {}}}",
+    file,
+    engine == Engine::VM ? "vm" : "tree",
+    wall_ms,
+    stats.allocs,
+    stats.frees,
+    stats.collections,
+    stats.peak,
+    peak_rss_kb
+  );
+}
 
 int
-exec(const char* filename) {
-  std::ifstream file(filename);
-  if(!file) {
+exec(
+  const char* filename,
+  Engine engine,
+  bool stats,
+  bool cached,
+  optimizer::Level level,
+  size_t jobs,
+  bool tails,
+  size_t max_stack
+) {
+  auto start = std::chrono::steady_clock::now();
+  Source source;
+  if(!source.open(filename)) {
     std::println(stderr, "eta: failed to open file '{}'", filename);
     return 1;
   }
 
-  std::stringstream ss;
-  ss << file.rdbuf();
+  std::string_view data = source.data();
 
-  const std::string& data = ss.str();
-  file.close();
+  // locations are 32-bit offsets into the source
+  if(data.length() > UINT32_MAX) {
+    std::println(stderr, "eta: file '{}' is too large", filename);
+    return 1;
+  }
 
   std::string _filename(filename);
   Lexer lexer(_filename, data);
-  parser::Parser parser(lexer);
-  ast::ProgramRef prgm = parser.parse();
-  const auto& errors = parser.errors();
+  std::string cachepath, cachesource;
+  if(cached) {
+    // entries are kept per file, the same file reached by another
+    // relative path or link shares its entry
+    std::error_code ec;
+    cachesource = std::filesystem::weakly_canonical(filename, ec).string();
+    if(ec) {
+      cachesource = _filename;
+    }
+    cachepath = cache::path(cachesource, level);
+  }
+
+  // the tail calls are found by the resolver, a cached program skips it
+  bool load = !cachepath.empty() && !tails;
+  ast::ProgramRef prgm = load ? cache::load(cachepath, cachesource, data) : nullptr;
 
-  if(errors.size() > 0) {
-    for(const auto& err: errors) {
-      std::println(stderr, "{}", err);
+  if(prgm == nullptr) {
+    std::vector<std::string> errors;
+    prgm = parser::parse(lexer, data, jobs, errors);
+
+    if(errors.size() > 0) {
+      for(const auto& err: errors) {
+        std::println(stderr, "{}", err);
+      }
+
+      return 1;
     }
 
-    return 1;
-  }
+    assert(prgm != nullptr && "this isn't normal... errors should be > 0");
+
+    optimizer::Optimizer optimizer(level);
+    optimizer.optimize(prgm);
 
-  assert(prgm != nullptr && "this isn't normal... errors should be > 0");
+    resolver::Resolver resolver;
+    resolver.resolve(prgm);
+
+    if(tails) {
+      for(const auto& loc: resolver.tail_calls()) {
+        std::println(stderr, "eta: tail call at {}", lexer.fmt_location(loc));
+      }
+    }
+
+    if(!cachepath.empty()) {
+      cache::store(cachepath, cachesource, data, prgm);
+    }
+  }
 
-  Eval eval(lexer);
   Scope scope;
+  ObjectRef result;
 
-  ObjectRef result = eval.evaluate(prgm, scope);
-  ObjectType type = result->type;
+  if(engine == Engine::VM) {
+    compiler::Compiler compiler;
+    bytecode::Module module = compiler.compile(prgm);
+    vm::VM vm(lexer, max_stack > 0 ? max_stack : vm::MAX_STACK);
+    result = vm.run(module, scope);
+  } else {
+    Eval eval(lexer, max_stack);
+    result = eval.evaluate(prgm, scope);
+  }
+
+  ObjectType type = result.type();
 
   if(type == ObjectType::DERR || type == ObjectType::SERR) {
     fflush(stdout);
-    std::println(stderr, "{}", result->value());
+    std::println(stderr, "{}", result.value());
+  }
+
+  #ifdef GC_DEBUG_INFO_ENABLE
+    fflush(stdout);
+    gc::Stats counters = gc::stats();
+    std::println(
+      stderr,
+      "gc: allocs {}, frees {}, collections {}, peak objects {}",
+      counters.allocs,
+      counters.frees,
+      counters.collections,
+      counters.peak
+    );
+  #endif
+
+  if(stats) {
+    print_stats(filename, engine, start);
   }
 
   gc::purge();
@@ -9,6 +9,34 @@
 #ifndef __EXEC_H__
 #define __EXEC_H__
 
-int exec(const char* filename);
+#include <cstddef>
+#include <optimizer.h>
+
+// selects what runs the parsed program
+enum Engine {
+  TREE = 0,
+  VM,
+};
+
+// with stats set a json line with the run time, gc counters and peak
+// rss is printed on stderr once the program finished. with cached set
+// the resolved program is kept on disk and later runs of the same
+// source skip lexing, parsing and resolving. level picks how much the
+// optimizer simplifies the tree before it is resolved and with jobs
+// above one a large source is parsed on that many threads. with tails
+// set the calls run as tail calls are listed on stderr. a program
+// nesting more than max_stack calls fails with a stack overflow, zero
+// keeps the engine's own limit: none on the tree walker beyond its
+// native stack and vm::MAX_STACK on the vm
+int exec(
+  const char* filename,
+  Engine engine = Engine::TREE,
+  bool stats = false,
+  bool cached = false,
+  optimizer::Level level = optimizer::Level::O1,
+  size_t jobs = 1,
+  bool tails = false,
+  size_t max_stack = 0
+);
 
 #endif
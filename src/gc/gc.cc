@@ -2,12 +2,225 @@
 #include <cstddef>
 #include <gc.h>
 #include <object.h>
-#include <map>
+#include <variant>
+#include <vector>
+#ifdef GC_POOL_ENABLE
+  #include <memory>
+  #include <new>
+#endif
 
+// deferred reference counting: an object whose count drops to zero is
+// queued in the zero count table and only freed at the next allocation,
+// so raw pointers stay valid in between. refcounting alone never frees
+// cycles (arrays and struct values can contain themselves), those are
+// found by trial deletion in two generations. every YOUNG_SIZE
+// allocations the objects allocated since the last collection are
+// checked on their own and the survivors become old, the whole heap is
+// only checked once the old generation has grown by `growth` since the
+// last full collection. both keep the cost amortized per allocation.
 namespace gc {
-  static constexpr size_t MAX_OBJ_ALLOC = 30;
-  static std::map<Object*, size_t> object_table;
-  static size_t active_objects = 0;
+  static constexpr size_t MAX_ZCT_SIZE = 256;
+  static constexpr size_t YOUNG_SIZE = 4096;
+  static constexpr size_t MIN_FULL_THRESHOLD = 4096;
+
+  // every live managed object, Object::index is the position in it.
+  // the old generation is the first `old` entries, the young one the rest
+  static std::vector<Object*> object_table;
+  static size_t old = 0;
+  static std::vector<Object*> zct;
+  static double growth = 2.0;
+  static size_t full_threshold = MIN_FULL_THRESHOLD;
+  static bool purged = false;
+  static Stats counters = {};
+
+  #ifdef GC_POOL_ENABLE
+    // objects are carved out of fixed size slabs and recycled through a
+    // free list, eta runs on a single thread so one pool is enough
+    static constexpr size_t SLAB_OBJECTS = 256;
+
+    union Block {
+      Block* next;
+      alignas(Object) unsigned char storage[sizeof(Object)];
+    };
+
+    static std::vector<std::unique_ptr<Block[]>> slabs;
+    static Block* free_list = nullptr;
+
+    static Object*
+    allocate() {
+      if(free_list == nullptr) {
+        slabs.push_back(std::make_unique<Block[]>(SLAB_OBJECTS));
+        Block* slab = slabs.back().get();
+        for(size_t i = SLAB_OBJECTS; i-- > 0;) {
+          slab[i].next = free_list;
+          free_list = &slab[i];
+        }
+      }
+
+      Block* block = free_list;
+      free_list = block->next;
+      return new (block->storage) Object;
+    }
+
+    static void
+    release(Object* o) {
+      o->~Object();
+      Block* block = reinterpret_cast<Block*>(o);
+      block->next = free_list;
+      free_list = block;
+    }
+  #else
+    static Object*
+    allocate() {
+      return new Object;
+    }
+
+    static void
+    release(Object* o) {
+      delete o;
+    }
+  #endif
+
+  template<typename F>
+  static void
+  children(Object* o, F f) {
+    auto visit = [&f](const ObjectRef& ref) {
+      if(ref.boxed() && ref && ref.get()->managed) {
+        f(ref.get());
+      }
+    };
+
+    switch(o->type) {
+      case ObjectType::ARRAY:
+        for(const auto& e: std::get<Array>(o->child).objects()) {
+          visit(e);
+        }
+        break;
+
+      case ObjectType::STRUCTVAL: {
+        const StructVal& sv = std::get<StructVal>(o->child);
+        visit(sv.parent);
+        for(const auto& v: sv.fields) {
+          visit(v);
+        }
+        break;
+      }
+
+      default:
+        break;
+    }
+  }
+
+  static void
+  move(Object* o, size_t index) {
+    o->index = index;
+    object_table[index] = o;
+  }
+
+  // the hole left by an old object is filled with the last old one and
+  // that one's place with the last young one, so both generations stay
+  // contiguous
+  static void
+  unlink(Object* o) {
+    size_t index = o->index;
+    if(index < old) {
+      old--;
+      move(object_table[old], index);
+      index = old;
+    }
+
+    move(object_table.back(), index);
+    object_table.pop_back();
+    counters.frees++;
+  }
+
+  // frees queued objects that are still unreferenced, freeing one may
+  // queue its children so this runs until the table is empty
+  static void
+  drain() {
+    while(!zct.empty()) {
+      Object* o = zct.back();
+      zct.pop_back();
+      o->queued = false;
+
+      if(o->refs == 0) {
+        unlink(o);
+        release(o);
+      }
+    }
+  }
+
+  // trial deletion over the objects from `from` on: counts that are left
+  // after subtracting the references held by those objects come from
+  // the rest of the heap or from outside it, everything not reachable
+  // from the objects holding them is garbage. a young collection treats
+  // references from old objects as roots, a cycle through an old
+  // object waits for a full one
+  static void
+  collect_cycles(size_t from) {
+    size_t n = object_table.size() - from;
+    std::vector<size_t> external(n);
+    for(size_t i = 0; i < n; i++) {
+      external[i] = object_table[from + i]->refs;
+    }
+
+    for(size_t i = 0; i < n; i++) {
+      children(object_table[from + i], [&external, from](Object* c) {
+        if(c->index >= from) {
+          external[c->index - from]--;
+        }
+      });
+    }
+
+    std::vector<bool> reachable(n, false);
+    std::vector<Object*> stack;
+    for(size_t i = 0; i < n; i++) {
+      if(external[i] > 0 && !reachable[i]) {
+        reachable[i] = true;
+        stack.push_back(object_table[from + i]);
+      }
+
+      while(!stack.empty()) {
+        Object* o = stack.back();
+        stack.pop_back();
+        children(o, [&reachable, &stack, from](Object* c) {
+          if(c->index >= from && !reachable[c->index - from]) {
+            reachable[c->index - from] = true;
+            stack.push_back(c);
+          }
+        });
+      }
+    }
+
+    std::vector<Object*> garbage;
+    for(size_t i = 0; i < n; i++) {
+      if(!reachable[i]) {
+        garbage.push_back(object_table[from + i]);
+      }
+    }
+
+    if(garbage.empty()) {
+      return;
+    }
+
+    // drop the references between garbage objects first so none of them
+    // is freed while another one still points to it. marking them
+    // queued keeps them out of the zero count table, while an object
+    // outside the collected range that loses its last reference here is
+    // queued as usual
+    for(Object* o: garbage) {
+      o->queued = true;
+    }
+
+    for(Object* o: garbage) {
+      o->child = Null{};
+    }
+
+    for(Object* o: garbage) {
+      unlink(o);
+      release(o);
+    }
+  }
 
   #ifdef GC_DEBUG_INFO_ENABLE
     void
@@ -15,46 +228,63 @@ namespace gc {
     static void
   #endif
   collect() {
-    for(auto it = object_table.begin(); it != object_table.end();) {
-      if(it->second == 0) {
-        delete it->first;
-        it = object_table.erase(it);
-        continue;
-      }
+    counters.collections++;
+    drain();
+    bool full = object_table.size() >= full_threshold;
+    collect_cycles(full ? 0 : old);
+    drain();
+    old = object_table.size();
 
-      it++;
+    if(full) {
+      size_t threshold = static_cast<size_t>(static_cast<double>(object_table.size()) * growth);
+      full_threshold = threshold > MIN_FULL_THRESHOLD ? threshold : MIN_FULL_THRESHOLD;
     }
   }
 
   ObjectRef alloc() {
-    if(active_objects >= MAX_OBJ_ALLOC) {
+    if(zct.size() >= MAX_ZCT_SIZE) {
+      drain();
+    }
+
+    if(object_table.size() - old >= YOUNG_SIZE) {
       collect();
-      active_objects = 0;
     }
 
-    Object* obj = new Object;
-    object_table[obj] = 0;
-    active_objects++;
+    Object* obj = allocate();
+    obj->managed = true;
+    obj->index = object_table.size();
+    object_table.push_back(obj);
+    counters.allocs++;
+    if(object_table.size() > counters.peak) {
+      counters.peak = object_table.size();
+    }
     return ObjectRef(obj);
   }
 
   Object* borrow(Object* o) {
-    if(object_table.contains(o)) {
-      object_table[o] = object_table[o] + 1;
+    if(o != nullptr && o->managed) {
+      o->refs++;
     }
     return o;
   }
 
   void done(Object* o) {
-    if(object_table.contains(o) && object_table[o] > 0) {
-      object_table[o] = object_table[o] - 1;
+    // refs outliving purge() point to freed objects
+    if(purged || o == nullptr || !o->managed || o->refs == 0) {
+      return;
+    }
+
+    o->refs--;
+    if(o->refs == 0 && !o->queued) {
+      o->queued = true;
+      zct.push_back(o);
     }
   }
 
   #ifdef GC_DEBUG_INFO_ENABLE
     size_t ref(Object* o) {
-      if(object_table.contains(o)) {
-        return object_table[o];
+      if(o != nullptr && o->managed) {
+        return o->refs;
       }
 
       return -1;
@@ -66,9 +296,25 @@ namespace gc {
   #endif
 
   void purge() {
-    for(auto it = object_table.begin(); it != object_table.end();) {
-      delete it->first;
-      it = object_table.erase(it);
+    purged = true;
+    for(Object* o: object_table) {
+      release(o);
     }
+    object_table.clear();
+    old = 0;
+    zct.clear();
+
+    #ifdef GC_POOL_ENABLE
+      free_list = nullptr;
+      slabs.clear();
+    #endif
+  }
+
+  void set_growth(double factor) {
+    growth = factor;
+  }
+
+  Stats stats() {
+    return counters;
   }
 };
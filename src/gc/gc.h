@@ -9,12 +9,19 @@
 #ifndef __GC_H__
 #define __GC_H__
 
+#include <cstddef>
 #include <object.h>
-#ifdef GC_DEBUG_INFO_ENABLE
-  #include <cstddef>
-#endif
 
 namespace gc {
+  // counters since startup, ints, floats, bools and null never reach
+  // the heap so they show up in none of them
+  struct Stats {
+    size_t allocs;
+    size_t frees;
+    size_t collections;
+    size_t peak;
+  };
+
   ObjectRef alloc();
   Object* borrow(Object*);
   #ifdef GC_DEBUG_INFO_ENABLE
@@ -26,6 +33,9 @@ namespace gc {
     size_t count();
   #endif
   void purge();
+  // the heap may grow by this factor between two full cycle collections
+  void set_growth(double);
+  Stats stats();
 };
 
 #endif
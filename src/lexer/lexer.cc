@@ -1,17 +1,36 @@
+#include <algorithm>
+#include <charconv>
 #include <cmath>
 #include <cstddef>
 #include <cstdio>
 #include <format>
+#include <iterator>
 #include <print>
 #include <string>
+#include <string_view>
+#include <system_error>
 #include <token.h>
 #include <cctype>
 #include <lexer.h>
 #include <map>
+#include <utility>
+#include <cstring>
+#if defined(__AVX2__)
+  #include <immintrin.h>
+  #define BLOCK_SCAN_ENABLE
+#elif defined(__SSE2__)
+  #include <emmintrin.h>
+  #define BLOCK_SCAN_ENABLE
+#endif
 
 using token::Token;
 
-static const std::map<std::string_view, Token> keywords = {
+struct Keyword {
+  std::string_view name;
+  Token token;
+};
+
+static constexpr Keyword keywords[] = {
   {"let", Token::LET},
   {"if", Token::IF},
   {"else", Token::ELSE},
@@ -30,6 +49,87 @@ static const std::map<std::string_view, Token> keywords = {
   {"struct", Token::STRUCT},
 };
 
+// keywords are classified with a perfect hash over the length and the
+// first two and last characters, the multiplier that makes it collision
+// free for the table size is searched at compile time
+static constexpr size_t KEYWORD_SLOTS = 64;
+
+static constexpr size_t
+keyword_hash(std::string_view s, uint64_t seed) {
+  const uint64_t parts[] = {
+    s.size(),
+    static_cast<unsigned char>(s[0]),
+    static_cast<unsigned char>(s[1]),
+    static_cast<unsigned char>(s[s.size() - 1]),
+  };
+
+  uint64_t h = seed;
+  for(uint64_t part: parts) {
+    h = (h ^ part) * 16777619;
+  }
+  return (h >> 32) % KEYWORD_SLOTS;
+}
+
+static constexpr bool
+keyword_seed_works(uint64_t seed) {
+  bool used[KEYWORD_SLOTS] = {};
+  for(const auto& k: keywords) {
+    size_t h = keyword_hash(k.name, seed);
+    if(used[h]) {
+      return false;
+    }
+    used[h] = true;
+  }
+  return true;
+}
+
+static constexpr uint64_t
+keyword_seed() {
+  for(uint64_t seed = 1; seed < 4096; seed++) {
+    if(keyword_seed_works(seed)) {
+      return seed;
+    }
+  }
+  return 0;
+}
+
+static constexpr uint64_t KEYWORD_SEED = keyword_seed();
+static_assert(KEYWORD_SEED != 0, "no perfect hash for the keywords");
+
+struct KeywordTable {
+  int8_t slots[KEYWORD_SLOTS];
+};
+
+static constexpr KeywordTable
+keyword_table() {
+  KeywordTable table = {};
+  for(size_t i = 0; i < KEYWORD_SLOTS; i++) {
+    table.slots[i] = -1;
+  }
+  for(size_t i = 0; i < std::size(keywords); i++) {
+    table.slots[keyword_hash(keywords[i].name, KEYWORD_SEED)] = static_cast<int8_t>(i);
+  }
+  return table;
+}
+
+static constexpr KeywordTable KEYWORD_TABLE = keyword_table();
+static constexpr size_t KEYWORD_MIN_LEN = 2;
+static constexpr size_t KEYWORD_MAX_LEN = 6;
+
+static Token
+keyword(std::string_view ident) {
+  if(ident.size() < KEYWORD_MIN_LEN || ident.size() > KEYWORD_MAX_LEN) {
+    return Token::IDENTIFIER;
+  }
+
+  int8_t i = KEYWORD_TABLE.slots[keyword_hash(ident, KEYWORD_SEED)];
+  if(i < 0 || keywords[i].name != ident) {
+    return Token::IDENTIFIER;
+  }
+
+  return keywords[i].token;
+}
+
 static const std::map<char, Token> specialchars = {
   {'(', Token::LPAREN},
   {')', Token::RPAREN},
@@ -55,7 +155,156 @@ static const std::map<char, Token> specialchars = {
   static void debug(const Token, const Value&);
 #endif
 
-Lexer::Lexer(const std::string& filename, const std::string& data):
+// the scanners below look at a block of bytes at once where the target
+// has SSE2 or AVX2 and fall back to one byte at a time elsewhere and for
+// the tail of the input. each returns the first position in [i, n)
+// whose byte is not in (or is in) the class it scans for, n if none
+#if defined(__AVX2__)
+  using Block = __m256i;
+  static constexpr size_t BLOCK_SIZE = 32;
+
+  static inline Block load(const char* p) { return _mm256_loadu_si256(reinterpret_cast<const Block*>(p)); }
+  static inline Block splat(char c) { return _mm256_set1_epi8(c); }
+  static inline Block eq(Block a, Block b) { return _mm256_cmpeq_epi8(a, b); }
+  static inline Block any(Block a, Block b) { return _mm256_or_si256(a, b); }
+  static inline Block sub(Block a, Block b) { return _mm256_sub_epi8(a, b); }
+  static inline Block minu(Block a, Block b) { return _mm256_min_epu8(a, b); }
+  static inline uint32_t mask(Block a) { return static_cast<uint32_t>(_mm256_movemask_epi8(a)); }
+  static constexpr uint32_t FULL_MASK = 0xffffffff;
+#elif defined(__SSE2__)
+  using Block = __m128i;
+  static constexpr size_t BLOCK_SIZE = 16;
+
+  static inline Block load(const char* p) { return _mm_loadu_si128(reinterpret_cast<const Block*>(p)); }
+  static inline Block splat(char c) { return _mm_set1_epi8(c); }
+  static inline Block eq(Block a, Block b) { return _mm_cmpeq_epi8(a, b); }
+  static inline Block any(Block a, Block b) { return _mm_or_si128(a, b); }
+  static inline Block sub(Block a, Block b) { return _mm_sub_epi8(a, b); }
+  static inline Block minu(Block a, Block b) { return _mm_min_epu8(a, b); }
+  static inline uint32_t mask(Block a) { return static_cast<uint32_t>(_mm_movemask_epi8(a)); }
+  static constexpr uint32_t FULL_MASK = 0xffff;
+#endif
+
+#ifdef BLOCK_SCAN_ENABLE
+  // bytes with lo <= b <= lo + width, compared unsigned
+  static inline Block
+  in_range(Block b, char lo, char width) {
+    Block x = sub(b, splat(lo));
+    return eq(minu(x, splat(width)), x);
+  }
+
+  static inline Block
+  space_block(Block b) {
+    return any(eq(b, splat(' ')), in_range(b, '\t', '\r' - '\t'));
+  }
+
+  static inline Block
+  ident_block(Block b) {
+    Block letter = in_range(any(b, splat(0x20)), 'a', 'z' - 'a');
+    return any(any(letter, in_range(b, '0', 9)), eq(b, splat('_')));
+  }
+
+  static inline Block
+  quote_block(Block b) {
+    return any(eq(b, splat('\'')), eq(b, splat('\\')));
+  }
+#endif
+
+static inline bool
+is_ident(char c) {
+  return isalpha(c) || isdigit(c) || c == '_';
+}
+
+static size_t
+skip_space(const char* data, size_t i, size_t n) {
+  #ifdef BLOCK_SCAN_ENABLE
+    for(; i + BLOCK_SIZE <= n; i += BLOCK_SIZE) {
+      uint32_t m = mask(space_block(load(data + i))) ^ FULL_MASK;
+      if(m != 0) {
+        return i + __builtin_ctz(m);
+      }
+    }
+  #endif
+
+  while(i < n && isspace(data[i])) {
+    i++;
+  }
+  return i;
+}
+
+static size_t
+skip_ident(const char* data, size_t i, size_t n) {
+  #ifdef BLOCK_SCAN_ENABLE
+    for(; i + BLOCK_SIZE <= n; i += BLOCK_SIZE) {
+      uint32_t m = mask(ident_block(load(data + i))) ^ FULL_MASK;
+      if(m != 0) {
+        return i + __builtin_ctz(m);
+      }
+    }
+  #endif
+
+  while(i < n && is_ident(data[i])) {
+    i++;
+  }
+  return i;
+}
+
+// the next quote or backslash
+static size_t
+find_quote(const char* data, size_t i, size_t n) {
+  #ifdef BLOCK_SCAN_ENABLE
+    for(; i + BLOCK_SIZE <= n; i += BLOCK_SIZE) {
+      uint32_t m = mask(quote_block(load(data + i)));
+      if(m != 0) {
+        return i + __builtin_ctz(m);
+      }
+    }
+  #endif
+
+  while(i < n && data[i] != '\'' && data[i] != '\\') {
+    i++;
+  }
+  return i;
+}
+
+static size_t
+find_newline(const char* data, size_t i, size_t n) {
+  const void* p = i < n ? memchr(data + i, '\n', n - i) : nullptr;
+  return p == nullptr ? n : static_cast<const char*>(p) - data;
+}
+
+// the character an escape sequence stands for, 0 when c does not start one
+static char
+escape(char c) {
+  switch(c) {
+    case 'n': return '\n';
+    case 't': return '\t';
+    case '\'': return '\'';
+    case '\\': return '\\';
+    default: return 0;
+  }
+}
+
+std::string
+unescape(std::string_view span) {
+  std::string str;
+  str.reserve(span.size());
+
+  for(size_t i = 0; i < span.size(); i++) {
+    char fc = 0;
+    if(span[i] == '\\' && i + 1 < span.size() && (fc = escape(span[i + 1])) != 0) {
+      str += fc;
+      i++;
+      continue;
+    }
+
+    str += span[i];
+  }
+
+  return str;
+}
+
+Lexer::Lexer(const std::string& filename, std::string_view data):
   _filename(filename), data(data) {
   _lasttoken = Token::NONE;
   loc = {0};
@@ -65,33 +314,56 @@ Lexer::Lexer(const std::string& filename, const std::string& data):
 
 bool
 Lexer::at_end() const {
-  return loc.cursor >= data.length();
+  return loc.offset >= data.length();
 }
 
 char
 Lexer::current_char() const {
   if(at_end()) return 0;
-  return data[loc.cursor];
+  return data[loc.offset];
 }
 
 char
 Lexer::peek_char() const {
-  if(loc.cursor + 1 >= data.length()) return 0;
-  return data[loc.cursor + 1];
+  if(loc.offset + 1 >= data.length()) return 0;
+  return data[loc.offset + 1];
 }
 
 void
 Lexer::advance_cursor() {
-  if(!at_end() &&
-    loc.cursor++ &&
-    !at_end() &&
-    current_char() == '\n'
-  ) {
-    loc.row++;
-    loc.linebeg = loc.cursor + 1;
+  if(!at_end()) {
+    loc.offset++;
+  }
+}
+
+void
+Lexer::advance_to(size_t target) {
+  if(target > data.length()) {
+    target = data.length();
+  }
+
+  if(loc.offset < target) {
+    loc.offset = target;
   }
 }
 
+// index of the line holding offset, the table is built on first use
+size_t
+Lexer::line_of(size_t offset) const {
+  if(lines.empty()) {
+    lines.push_back(0);
+    for(size_t i = find_newline(data.data(), 0, data.length());
+      i < data.length();
+      i = find_newline(data.data(), i + 1, data.length())
+    ) {
+      lines.push_back(i + 1);
+    }
+  }
+
+  auto it = std::upper_bound(lines.begin(), lines.end(), offset);
+  return std::distance(lines.begin(), it) - 1;
+}
+
 void
 Lexer::save_location() {
   lastloc = loc;
@@ -99,16 +371,12 @@ Lexer::save_location() {
 
 void
 Lexer::skip_whitespaces() {
-  while(!at_end() && isspace(current_char())) {
-    advance_cursor();
-  }
+  advance_to(skip_space(data.data(), loc.offset, data.length()));
 }
 
 void
 Lexer::drop_line() {
-  while(!at_end() && current_char() != '\n') {
-    advance_cursor();
-  }
+  advance_to(find_newline(data.data(), loc.offset, data.length()));
 }
 
 Token
@@ -124,20 +392,12 @@ Lexer::next_token_() {
   if(at_end()) return Token::EOF_;
 
   if(isalpha(current_char()) || current_char() == '_') {
-    while(!at_end() &&
-      (isalpha(current_char()) || isdigit(current_char()) || current_char() == '_')
-    ) {
-      advance_cursor();
-    }
+    advance_to(skip_ident(data.data(), loc.offset, data.length()));
 
-    std::string ident = data.substr(lastloc.cursor, loc.cursor - lastloc.cursor);
+    std::string_view ident(data.data() + lastloc.offset, loc.offset - lastloc.offset);
     _value = ident;
 
-    if(!keywords.contains(ident)) {
-      return Token::IDENTIFIER;
-    }
-
-    Token token = keywords.at(ident);
+    Token token = keyword(ident);
     if(token == Token::BOOLLIT) {
       _value = ident == "true";
     }
@@ -158,51 +418,41 @@ Lexer::next_token_() {
       advance_cursor();
     }
 
-    std::string value = data.substr(lastloc.cursor, loc.cursor - lastloc.cursor);
+    const char* begin = data.data() + lastloc.offset;
+    const char* end = data.data() + loc.offset;
     if(isfloat) {
-      _value = std::stod(value);
+      double value = 0;
+      if(std::from_chars(begin, end, value).ec != std::errc()) {
+        return Token::ERROR;
+      }
+      _value = value;
       return Token::FLOATLIT;
     }
 
-    _value = std::stoll(value);
+    int64_t value = 0;
+    if(std::from_chars(begin, end, value).ec != std::errc()) {
+      return Token::ERROR;
+    }
+    _value = value;
     return Token::INTLIT;
   }
 
   if(current_char() == '\'') {
     advance_cursor();
-    std::string str;
-
-    while(!at_end() && current_char() != '\'') {
-      char c = current_char(), fc = c;
-
-      if(c == '\\') {
-        switch(peek_char()) {
-          case 'n':
-            fc = '\n';
-            break;
+    size_t begin = loc.offset;
 
-          case 't':
-            fc = '\t';
-            break;
-
-          case '\'':
-            fc = '\'';
-            break;
-
-          case '\\':
-            fc = '\\';
-            advance_cursor();
-        }
+    while(true) {
+      advance_to(find_quote(data.data(), loc.offset, data.length()));
+      if(at_end() || current_char() == '\'') {
+        break;
       }
 
-      if(fc != c)
-        advance_cursor();
-
-      str += fc;
-      advance_cursor();
+      // an escaped quote does not end the literal, unescape() replaces
+      // the escapes once the parser needs the text
+      advance_to(loc.offset + (escape(peek_char()) != 0 ? 2 : 1));
     }
 
-    _value = str;
+    _value = std::string_view(data.data() + begin, loc.offset - begin);
     advance_cursor();
     return Token::STRINGLIT;
   }
@@ -339,12 +589,16 @@ Lexer::filename() const {
 
 std::string
 Lexer::current_line() const {
-  size_t i = data.find('\n', lastloc.linebeg);
-  if(i == std::string::npos) {
-    return data;
-  }
+  size_t begin = lines[line_of(lastloc.offset)];
+  size_t end = find_newline(data.data(), begin, data.length());
+  return std::string(data.substr(begin, end - begin));
+}
 
-  return data.substr(lastloc.linebeg, i - lastloc.linebeg);
+std::string
+Lexer::fmt_location(const Location& _loc) const {
+  size_t row = line_of(_loc.offset);
+  size_t column = _loc.offset - lines[row];
+  return std::format("{}:{}:{}", _filename, row + 1, column + 1);
 }
 
 std::string
@@ -352,37 +606,114 @@ Lexer::fmt_error(const Location& _loc, const std::string& msg) {
   set_location(_loc);
   next_token();
 
+  size_t row = line_of(lastloc.offset);
+  size_t column = lastloc.offset - lines[row];
+
   std::string errmsg = std::format(
     "\neta: \e[31merror in file: {}:{}:{}\e[0m\n",
     _filename,
-    lastloc.row + 1,
-    lastloc.cursor - lastloc.linebeg + 1
+    row + 1,
+    column + 1
   );
 
   errmsg += std::format(
     "{} | {}\n",
-    lastloc.row + 1,
+    row + 1,
     current_line()
   );
 
-  size_t uppyarrw = loc.cursor - lastloc.cursor;
+  size_t uppyarrw = loc.offset - lastloc.offset;
   errmsg += std::format(
     "{}{}   \e[31m{}\e[0m\n",
-    std::string(floor(log10(lastloc.row + 1) + 1), ' '),
-    std::string(lastloc.cursor - lastloc.linebeg, ' '),
+    std::string(floor(log10(row + 1) + 1), ' '),
+    std::string(column, ' '),
     std::string(uppyarrw + 1 * (uppyarrw <= 0), '^')
   );
 
   errmsg += std::format(
     "{}{}   \e[31m{}\e[0m",
-    std::string(floor(log10(lastloc.row + 1) + 1), ' '),
-    std::string(lastloc.cursor - lastloc.linebeg, ' '),
+    std::string(floor(log10(row + 1) + 1), ' '),
+    std::string(column, ' '),
     msg
   );
 
   return errmsg;
 }
 
+TokenStream::TokenStream(Lexer& lexer)
+  :lexer(lexer) {
+  current = Lexeme{
+    .token = Token::NONE,
+    .value = lexer.get_value(),
+    .start = lexer.last_location(),
+    .end = lexer.location()
+  };
+  next = scan();
+}
+
+TokenStream::Lexeme
+TokenStream::scan() {
+  Token token = lexer.next_token();
+  return Lexeme{
+    .token = token,
+    .value = lexer.get_value(),
+    .start = lexer.last_location(),
+    .end = lexer.location()
+  };
+}
+
+Token
+TokenStream::next_token() {
+  current = std::move(next);
+  // EOF_ and ERROR repeat once reached, the lexer does not move past them
+  if(current.token != Token::EOF_ && current.token != Token::ERROR) {
+    next = scan();
+  } else {
+    next = current;
+  }
+  return current.token;
+}
+
+Token
+TokenStream::last_token() const {
+  return current.token;
+}
+
+Token
+TokenStream::peek_token() const {
+  return next.token;
+}
+
+const Value&
+TokenStream::get_value() const {
+  return current.value;
+}
+
+const Location&
+TokenStream::location() const {
+  return current.end;
+}
+
+const Location&
+TokenStream::last_location() const {
+  return current.start;
+}
+
+std::string
+TokenStream::fmt_error(const Location& loc, const std::string& msg) {
+  // formatting rewinds the lexer to the token at loc, the parser carries
+  // on from there so the stream follows it
+  std::string errmsg = lexer.fmt_error(loc, msg);
+  current = Lexeme{
+    .token = lexer.last_token(),
+    .value = lexer.get_value(),
+    .start = lexer.last_location(),
+    .end = lexer.location()
+  };
+  next = scan();
+  return errmsg;
+}
+
 #ifdef TOKENS_DEBUG_INFO_ENABLE
   static void
   debug(const Token t, const Value& v) {
@@ -402,7 +733,7 @@ Lexer::fmt_error(const Location& _loc, const std::string& msg) {
 
       case Token::IDENTIFIER:
       case Token::STRINGLIT:
-        std::println(" | value: {}", std::get<std::string>(v));
+        std::println(" | value: {}", std::get<std::string_view>(v));
         break;
 
       default:
@@ -13,19 +13,23 @@
 #include <cstdint>
 #include <token.h>
 #include <string>
+#include <string_view>
 #include <variant>
+#include <vector>
 
+// byte offset into the source, the row and column are looked up in the
+// lexer's line table only when an error is formatted
 struct Location {
-  size_t cursor;
-  size_t row;
-  size_t linebeg;
+  uint32_t offset;
 };
 
-using Value = std::variant<int64_t, double, bool, std::string>;
+// identifiers, keywords and string literals are spans of the source,
+// string literals without their quotes and escapes still in place
+using Value = std::variant<int64_t, double, bool, std::string_view>;
 
 class Lexer {
 public:
-  Lexer(const std::string& filename, const std::string& data);
+  Lexer(const std::string& filename, std::string_view data);
   void set_location(const Location&);
   token::Token next_token();
   token::Token last_token() const;
@@ -36,23 +40,62 @@ public:
   const Location& last_location() const;
   const std::string& filename() const;
   std::string fmt_error(const Location&, const std::string&);
+  // file:row:column of a location
+  std::string fmt_location(const Location&) const;
 
 private:
   bool at_end() const;
   char current_char() const;
   char peek_char() const;
   void advance_cursor();
+  void advance_to(size_t);
   void save_location();
   void skip_whitespaces();
   void drop_line();
+  size_t line_of(size_t) const;
   token::Token next_token_();
 
   const std::string& _filename;
-  const std::string& data;
+  // the source, owned by the caller for as long as the lexer is used
+  std::string_view data;
   token::Token _lasttoken;
   Location loc;
   Location lastloc;
   Value _value;
+  // offset of the first character of every line, filled in by the
+  // first error so lexing itself never looks at newlines
+  mutable std::vector<uint32_t> lines;
+};
+
+// text of a string literal span with its escapes replaced
+std::string unescape(std::string_view);
+
+// tokens with one token of lookahead, every token is lexed exactly once
+// instead of peek_token() copying the lexer and scanning it again
+class TokenStream {
+public:
+  TokenStream(Lexer&);
+  token::Token next_token();
+  token::Token last_token() const;
+  token::Token peek_token() const;
+  const Value& get_value() const;
+  const Location& location() const;
+  const Location& last_location() const;
+  std::string fmt_error(const Location&, const std::string&);
+
+private:
+  struct Lexeme {
+    token::Token token;
+    Value value;
+    Location start;
+    Location end;
+  };
+
+  Lexeme scan();
+
+  Lexer& lexer;
+  Lexeme current;
+  Lexeme next;
 };
 
 #endif
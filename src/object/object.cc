@@ -1,9 +1,16 @@
 #include "token.h"
+#include <algorithm>
 #include <cstddef>
 #include <format>
+#include <memory>
 #include <object.h>
 #include <string>
+#include <utility>
 #include <print>
+#include <cstdint>
+#include <vector>
+#include <variant>
+#include <type_traits>
 
 namespace gc {
   extern Object* borrow(Object*);
@@ -19,7 +26,6 @@ static const char* const objectstr[__OBJECTTYPECOUNT__]  = {
   "array",
   "struct",
   "",
-  "return value",
   "error",
   "error",
   "function",
@@ -29,74 +35,110 @@ static const char* const objectstr[__OBJECTTYPECOUNT__]  = {
 };
 
 ObjectRef::ObjectRef() {
-  obj = nullptr;
+  tag = HEAP;
+  as.obj = nullptr;
 }
 
 ObjectRef::ObjectRef(Object* o) {
-  obj = gc::borrow(o);
+  tag = HEAP;
+  as.obj = gc::borrow(o);
+}
+
+ObjectRef::ObjectRef(Null) {
+  tag = ObjectType::NULL_;
+  as.i = 0;
+}
+
+ObjectRef::ObjectRef(Int v) {
+  tag = ObjectType::INT;
+  as.i = v.value;
+}
+
+ObjectRef::ObjectRef(Float v) {
+  tag = ObjectType::FLOAT;
+  as.f = v.value;
+}
+
+ObjectRef::ObjectRef(Bool v) {
+  tag = ObjectType::BOOL;
+  as.i = v.value;
 }
 
 ObjectRef::ObjectRef(const ObjectRef& o) {
-  obj = gc::borrow(o.obj);
+  tag = o.tag;
+  as = o.as;
+  if(tag == HEAP) {
+    gc::borrow(as.obj);
+  }
 }
 
 const ObjectRef&
 ObjectRef::operator=(const ObjectRef& o) {
-  if(obj != nullptr) {
-    gc::done(obj);
+  if(o.tag == HEAP) {
+    gc::borrow(o.as.obj);
   }
 
-  obj = gc::borrow(o.obj);
+  if(tag == HEAP) {
+    gc::done(as.obj);
+  }
+
+  tag = o.tag;
+  as = o.as;
   return *this;
 }
 
 
 ObjectRef::operator bool() const {
-  return obj != nullptr;
+  return tag != HEAP || as.obj != nullptr;
 }
 
 const Object&
 ObjectRef::operator*() const {
-  if(obj == nullptr) {
-    std::println(stderr, "ObjectRef: a nullptr was dereferenced");
-    exit(1);
-  }
-
-  return *obj;
+  return *get();
 }
 
 Object*
 ObjectRef::operator->() {
-  if(obj == nullptr) {
-    std::println(stderr, "ObjectRef: a nullptr was dereferenced");
-    exit(1);
-  }
-
-  return obj;
+  return get();
 }
 
 const Object*
 ObjectRef::operator->() const {
-  if(obj == nullptr) {
-    std::println(stderr, "ObjectRef: a nullptr was dereferenced");
-    exit(1);
-  }
-
-  return obj;
+  return get();
 }
 
 Object*
 ObjectRef::get() const {
-  if(obj == nullptr) {
+  if(tag != HEAP) {
+    std::println(stderr, "ObjectRef: an immediate '{}' was dereferenced", to_string(tag));
+    exit(1);
+  }
+
+  if(as.obj == nullptr) {
     std::println(stderr, "ObjectRef: a nullptr was dereferenced");
     exit(1);
   }
 
-  return obj;
+  return as.obj;
 }
 
 ObjectRef::~ObjectRef() {
-  gc::done(obj);
+  if(tag == HEAP) {
+    gc::done(as.obj);
+  }
+}
+
+bool
+ObjectRef::same(const ObjectRef& o) const {
+  if(tag != o.tag) {
+    return false;
+  }
+
+  switch(tag) {
+    case HEAP: return as.obj == o.as.obj;
+    case ObjectType::FLOAT: return as.f == o.as.f;
+    default: return as.i == o.as.i;
+  }
 }
 
 std::string
@@ -124,17 +166,201 @@ to_string(const Bool& b) {
   return std::format("{}", b.value ? "true" : "false");
 }
 
+String::String()
+  :text(std::make_shared<std::string>()) {}
+
+String::String(std::string value)
+  :text(std::make_shared<std::string>(std::move(value))) {}
+
+String::String(ast::Constant constant)
+  :text(std::move(constant)) {}
+
+const std::string&
+String::value() const {
+  return *text;
+}
+
+std::string&
+String::mutable_value() {
+  if(text.use_count() > 1) {
+    text = std::make_shared<std::string>(*text);
+  }
+
+  return *text;
+}
+
+Array::Array()
+  :elements(std::vector<ObjectRef>()) {}
+
+Array::Array(std::vector<ObjectRef> values)
+  :elements(std::move(values)) {
+  const auto& objects = std::get<OBJECTS>(elements);
+  if(objects.empty()) {
+    return;
+  }
+
+  ObjectType type = objects.front().type();
+  for(const auto& obj: objects) {
+    if(obj.type() != type) {
+      return;
+    }
+  }
+
+  switch(type) {
+    case ObjectType::INT: {
+      std::vector<int64_t> ints;
+      ints.reserve(objects.size());
+      for(const auto& obj: objects) {
+        ints.push_back(obj.as_int());
+      }
+      elements = std::move(ints);
+      break;
+    }
+
+    case ObjectType::FLOAT: {
+      std::vector<double> floats;
+      floats.reserve(objects.size());
+      for(const auto& obj: objects) {
+        floats.push_back(obj.as_float());
+      }
+      elements = std::move(floats);
+      break;
+    }
+
+    case ObjectType::BOOL: {
+      std::vector<uint8_t> bools;
+      bools.reserve(objects.size());
+      for(const auto& obj: objects) {
+        bools.push_back(obj.as_bool());
+      }
+      elements = std::move(bools);
+      break;
+    }
+
+    default:
+      break;
+  }
+}
+
+bool
+Array::fits(const ObjectRef& obj) const {
+  switch(kind()) {
+    case INTS: return obj.type() == ObjectType::INT;
+    case FLOATS: return obj.type() == ObjectType::FLOAT;
+    case BOOLS: return obj.type() == ObjectType::BOOL;
+    default: return true;
+  }
+}
+
+void
+Array::box() {
+  if(kind() == OBJECTS) {
+    return;
+  }
+
+  std::vector<ObjectRef> objects;
+  objects.reserve(size());
+  for(size_t i = 0; i < size(); i++) {
+    objects.push_back(at(i));
+  }
+  elements = std::move(objects);
+}
+
+void
+Array::set(size_t i, const ObjectRef& obj) {
+  if(!fits(obj)) {
+    box();
+  }
+
+  switch(kind()) {
+    case INTS: std::get<INTS>(elements)[i] = obj.as_int(); break;
+    case FLOATS: std::get<FLOATS>(elements)[i] = obj.as_float(); break;
+    case BOOLS: std::get<BOOLS>(elements)[i] = obj.as_bool(); break;
+    default: std::get<OBJECTS>(elements)[i] = obj; break;
+  }
+}
+
+void
+Array::push(const ObjectRef& obj) {
+  // an empty array takes the kind of its first element
+  if(size() == 0) {
+    switch(obj.type()) {
+      case ObjectType::INT: elements = std::vector<int64_t>(); break;
+      case ObjectType::FLOAT: elements = std::vector<double>(); break;
+      case ObjectType::BOOL: elements = std::vector<uint8_t>(); break;
+      default: elements = std::vector<ObjectRef>(); break;
+    }
+  }
+
+  if(!fits(obj)) {
+    box();
+  }
+
+  switch(kind()) {
+    case INTS: std::get<INTS>(elements).push_back(obj.as_int()); break;
+    case FLOATS: std::get<FLOATS>(elements).push_back(obj.as_float()); break;
+    case BOOLS: std::get<BOOLS>(elements).push_back(obj.as_bool()); break;
+    default: std::get<OBJECTS>(elements).push_back(obj); break;
+  }
+}
+
+void
+Array::pop() {
+  if(size() == 0) {
+    return;
+  }
+
+  std::visit([](auto& v) { v.pop_back(); }, elements);
+}
+
+Array
+Array::slice(size_t start, size_t end) const {
+  Array a;
+  std::visit([&a, start, end](const auto& v) {
+    using Vector = std::decay_t<decltype(v)>;
+    a.elements = Vector(v.begin() + start, v.begin() + end);
+  }, elements);
+  return a;
+}
+
+const std::vector<ObjectRef>&
+Array::objects() const {
+  static const std::vector<ObjectRef> none;
+  return kind() == OBJECTS ? std::get<OBJECTS>(elements) : none;
+}
+
+Struct::Struct(std::string name, const std::map<std::string, std::string>& fields)
+  :name(std::move(name)) {
+  static uint64_t shapes = 0;
+  shape = ++shapes;
+
+  for(const auto& [field, type]: fields) {
+    this->fields.push_back(field);
+    types.push_back(type);
+  }
+}
+
+size_t
+Struct::slot(std::string_view field) const {
+  auto it = std::lower_bound(fields.begin(), fields.end(), field);
+  if(it == fields.end() || *it != field) {
+    return NONE;
+  }
+
+  return it - fields.begin();
+}
+
 std::string
 to_string(const String& s) {
-  return s.value;
+  return s.value();
 }
 
 std::string
 to_string(const Array& a) {
   std::string arrval = "[";
-  for(size_t i = 0; i < a.elements.size(); i++) {
-    arrval += (*a.elements[i]).value();
-    arrval += i < a.elements.size() - 1 ? ", " : "";
+  for(size_t i = 0; i < a.size(); i++) {
+    arrval += a.at(i).value();
+    arrval += i < a.size() - 1 ? ", " : "";
   }
   arrval += "]";
   return arrval;
@@ -145,11 +371,9 @@ to_string(const Struct& s) {
   using token::Token;
 
   std::string fields = "{";
-  size_t i = 0;
-  for(const auto& [k, v]: s.fields) {
-    fields += k + ": " + v;
+  for(size_t i = 0; i < s.fields.size(); i++) {
+    fields += s.fields[i] + ": " + s.types[i];
     fields += i < s.fields.size() - 1 ? ", " : "";
-    i++;
   }
   fields += "}";
   return s.name + fields;
@@ -157,20 +381,14 @@ to_string(const Struct& s) {
 
 std::string
 to_string(const StructVal& s) {
+  const Struct& parent = std::get<Struct>(s.parent->child);
   std::string fields = "{";
-  size_t i = 0;
-  for(const auto& [k, v]: s.fields) {
-    fields += k + ": " + v->value();
+  for(size_t i = 0; i < s.fields.size(); i++) {
+    fields += parent.fields[i] + ": " + s.fields[i].value();
     fields += i < s.fields.size() - 1 ? ", " : "";
-    i++;
   }
   fields += "}";
-  return std::get<Struct>(s.parent->child).name + fields;
-}
-
-std::string
-to_string(const RetVal& rv) {
-  return (*rv.value).value();
+  return parent.name + fields;
 }
 
 std::string
@@ -193,6 +411,17 @@ to_string(const ELib& l) {
   return to_string(ObjectType::ELIB);
 }
 
+std::string
+ObjectRef::value() const {
+  switch(tag) {
+    case ObjectType::NULL_: return to_string(Null{});
+    case ObjectType::INT: return to_string(Int{.value = as.i});
+    case ObjectType::FLOAT: return to_string(Float{.value = as.f});
+    case ObjectType::BOOL: return to_string(Bool{.value = as.i != 0});
+    default: return get()->value();
+  }
+}
+
 std::string
 Object::value() const {
   return std::visit([](const auto& child) { return to_string(child); }, child);
@@ -9,9 +9,11 @@
 #ifndef __OBJECT_H__
 #define __OBJECT_H__
 
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <string>
+#include <string_view>
 #include <variant>
 #include <vector>
 #include <token.h>
@@ -27,7 +29,6 @@ enum ObjectType {
   ARRAY,
   STRUCT,
   STRUCTVAL,
-  RETVAL,
   SERR,
   DERR,
   FUNC,
@@ -39,11 +40,35 @@ enum ObjectType {
 
 struct Object;
 
-// class for managing object lifetime
+namespace bytecode {
+  struct Chunk;
+};
+
+struct Null {
+};
+
+struct Int {
+  int64_t value;
+};
+
+struct Float {
+  double value;
+};
+
+struct Bool {
+  bool value;
+};
+
+// a value in eta: null, int, float and bool are carried inline, every
+// other type lives in a gc managed heap Object that is ref counted
 class ObjectRef {
 public:
   ObjectRef();
   ObjectRef(Object*);
+  ObjectRef(Null);
+  ObjectRef(Int);
+  ObjectRef(Float);
+  ObjectRef(Bool);
   ObjectRef(const ObjectRef&);
   const ObjectRef& operator=(const ObjectRef&);
   explicit operator bool() const;
@@ -53,52 +78,109 @@ public:
   Object* get() const;
   ~ObjectRef();
 
+  ObjectType type() const;
+  bool boxed() const;
+  int64_t as_int() const;
+  double as_float() const;
+  bool as_bool() const;
+  // identity, immediates compare by value and heap objects by address
+  bool same(const ObjectRef&) const;
+  std::string value() const;
+
 private:
-  Object* obj;
+  // tag is the type of an immediate, or HEAP for refs to an Object
+  static constexpr ObjectType HEAP = __OBJECTTYPECOUNT__;
+
+  union Payload {
+    Object* obj;
+    int64_t i;
+    double f;
+  };
+
+  ObjectType tag;
+  Payload as;
 };
 
 using BuiltinFn = std::function<ObjectRef(const std::vector<ObjectRef>&)>;
 
-struct Null {
-};
+// copies of a string share its characters, the first write through
+// mutable_value() gives the writer its own copy
+class String {
+public:
+  String();
+  String(std::string);
+  String(ast::Constant);
+  const std::string& value() const;
+  std::string& mutable_value();
 
-struct Int {
-  int64_t value;
+private:
+  ast::Constant text;
 };
 
-struct Float {
-  double value;
-};
+// elements of an array, kept unboxed in a contiguous int64_t[], double[]
+// or bool[] while all of them have that type. storing an element of any
+// other type moves the array to a list of ObjectRefs for good
+class Array {
+public:
+  enum Kind {
+    INTS = 0,
+    FLOATS,
+    BOOLS,
+    OBJECTS,
+  };
 
-struct Bool {
-  bool value;
-};
+  Array();
+  Array(std::vector<ObjectRef>);
+  Kind kind() const;
+  size_t size() const;
+  ObjectRef at(size_t) const;
+  void set(size_t, const ObjectRef&);
+  void push(const ObjectRef&);
+  void pop();
+  // copy of the elements in [start, end)
+  Array slice(size_t start, size_t end) const;
+  // the elements of an OBJECTS array, empty for the unboxed kinds
+  const std::vector<ObjectRef>& objects() const;
 
-struct String {
-  std::string value;
-};
+private:
+  bool fits(const ObjectRef&) const;
+  void box();
 
-struct Array {
-  std::vector<ObjectRef> elements;
+  std::variant<
+    std::vector<int64_t>,
+    std::vector<double>,
+    std::vector<uint8_t>,
+    std::vector<ObjectRef>
+  > elements;
 };
 
+// a struct definition with its fields sorted by name, a value of the
+// struct keeps field i in slot i. shape is unique to every evaluated
+// definition so member caches can tell them apart
 struct Struct {
+  static constexpr size_t NONE = SIZE_MAX;
+
+  Struct(std::string name, const std::map<std::string, std::string>& fields);
+  // slot of a field, NONE when the struct has no field of that name
+  size_t slot(std::string_view field) const;
+
   std::string name;
-  std::map<std::string, std::string> fields;
+  std::vector<std::string> fields;
+  std::vector<std::string> types;
+  uint64_t shape;
 };
 
 struct StructVal {
   ObjectRef parent;
-  std::map<std::string, ObjectRef> fields;
-};
-
-struct RetVal {
-  ObjectRef value;
+  // indexed by the slots of the parent struct
+  std::vector<ObjectRef> fields;
 };
 
 struct Func {
   std::vector<ast::IdentifierRef> parameters;
-  ast::BlockStmtRef body;
+  ast::BlockStmtRef body = nullptr;
+  // set when the function was compiled for the vm
+  const bytecode::Chunk* chunk = nullptr;
 };
 
 struct BFunc {
@@ -117,14 +199,10 @@ struct ELib {
 
 using ObjectChild = std::variant<
   Null,
-  Int,
-  Float,
-  Bool,
   String,
   Array,
   Struct,
   StructVal,
-  RetVal,
   Func,
   BFunc,
   EFunc,
@@ -134,10 +212,67 @@ using ObjectChild = std::variant<
 struct Object {
   ObjectType type;
   ObjectChild child;
+  // gc header, only objects from gc::alloc() are counted, static ones
+  // are not. queued marks an object waiting in the zero count table and
+  // index is its position in the table of live objects
+  bool managed = false;
+  bool queued = false;
+  size_t refs = 0;
+  size_t index = 0;
 
   std::string value() const;
 };
 
 std::string to_string(ObjectType);
 
+inline ObjectType
+ObjectRef::type() const {
+  return tag == HEAP ? get()->type : tag;
+}
+
+inline bool
+ObjectRef::boxed() const {
+  return tag == HEAP;
+}
+
+inline int64_t
+ObjectRef::as_int() const {
+  return as.i;
+}
+
+inline double
+ObjectRef::as_float() const {
+  return as.f;
+}
+
+inline bool
+ObjectRef::as_bool() const {
+  return as.i != 0;
+}
+
+inline Array::Kind
+Array::kind() const {
+  return static_cast<Kind>(elements.index());
+}
+
+inline size_t
+Array::size() const {
+  switch(kind()) {
+    case INTS: return std::get<INTS>(elements).size();
+    case FLOATS: return std::get<FLOATS>(elements).size();
+    case BOOLS: return std::get<BOOLS>(elements).size();
+    default: return std::get<OBJECTS>(elements).size();
+  }
+}
+
+inline ObjectRef
+Array::at(size_t i) const {
+  switch(kind()) {
+    case INTS: return Int{.value = std::get<INTS>(elements)[i]};
+    case FLOATS: return Float{.value = std::get<FLOATS>(elements)[i]};
+    case BOOLS: return Bool{.value = std::get<BOOLS>(elements)[i] != 0};
+    default: return std::get<OBJECTS>(elements)[i];
+  }
+}
+
 #endif
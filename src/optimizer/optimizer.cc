@@ -0,0 +1,461 @@
+#include <optimizer.h>
+#include <ast.h>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+#include <token.h>
+#include <utility>
+#include <variant>
+#include <vector>
+
+using token::Token;
+using ast::StmtType;
+using ast::ExprType;
+
+namespace optimizer {
+static ast::Expr
+integer_lit(const Location& loc, int64_t value) {
+  return ast::Expr{
+    .type = ExprType::INTEGERLIT,
+    .child = ast::IntegerLit{.location = loc, .value = value}
+  };
+}
+
+static ast::Expr
+float_lit(const Location& loc, double value) {
+  return ast::Expr{
+    .type = ExprType::FLOATLIT,
+    .child = ast::FloatLit{.location = loc, .value = value}
+  };
+}
+
+static ast::Expr
+bool_lit(const Location& loc, bool value) {
+  return ast::Expr{
+    .type = ExprType::BOOLLIT,
+    .child = ast::BoolLit{.location = loc, .value = value}
+  };
+}
+
+// the folds below follow binary() and unary() in eval, an operation
+// they would turn into an error (or that is undefined in c++) gives
+// nullopt and stays in the tree
+static std::optional<ast::Expr>
+fold(Token op, const Location& loc, int64_t l, int64_t r) {
+  int64_t value = 0;
+
+  switch(op) {
+    case Token::ADD:
+      if(__builtin_add_overflow(l, r, &value)) return std::nullopt;
+      return integer_lit(loc, value);
+
+    case Token::SUB:
+      if(__builtin_sub_overflow(l, r, &value)) return std::nullopt;
+      return integer_lit(loc, value);
+
+    case Token::MUL:
+      if(__builtin_mul_overflow(l, r, &value)) return std::nullopt;
+      return integer_lit(loc, value);
+
+    case Token::DIV:
+      if(r == 0 || (l == std::numeric_limits<int64_t>::min() && r == -1)) {
+        return std::nullopt;
+      }
+      return integer_lit(loc, l / r);
+
+    case Token::LES: return bool_lit(loc, l < r);
+    case Token::LEE: return bool_lit(loc, l <= r);
+    case Token::GRT: return bool_lit(loc, l > r);
+    case Token::GRE: return bool_lit(loc, l >= r);
+    case Token::EQL: return bool_lit(loc, l == r);
+    case Token::NEQL: return bool_lit(loc, l != r);
+
+    default:
+      return std::nullopt;
+  }
+}
+
+static std::optional<ast::Expr>
+fold(Token op, const Location& loc, double l, double r) {
+  switch(op) {
+    case Token::ADD: return float_lit(loc, l + r);
+    case Token::SUB: return float_lit(loc, l - r);
+    case Token::MUL: return float_lit(loc, l * r);
+    case Token::DIV: return float_lit(loc, l / r);
+    case Token::LES: return bool_lit(loc, l < r);
+    case Token::LEE: return bool_lit(loc, l <= r);
+    case Token::GRT: return bool_lit(loc, l > r);
+    case Token::GRE: return bool_lit(loc, l >= r);
+    case Token::EQL: return bool_lit(loc, l == r);
+    case Token::NEQL: return bool_lit(loc, l != r);
+
+    default:
+      return std::nullopt;
+  }
+}
+
+static std::optional<ast::Expr>
+fold(Token op, const Location& loc, const std::string& l, const std::string& r) {
+  switch(op) {
+    case Token::ADD:
+      return ast::Expr{
+        .type = ExprType::STRINGLIT,
+        .child = ast::StringLit{
+          .location = loc,
+          .value = std::make_shared<std::string>(l + r)
+        }
+      };
+
+    case Token::LES: return bool_lit(loc, l < r);
+    case Token::LEE: return bool_lit(loc, l <= r);
+    case Token::GRT: return bool_lit(loc, l > r);
+    case Token::GRE: return bool_lit(loc, l >= r);
+    case Token::EQL: return bool_lit(loc, l == r);
+    case Token::NEQL: return bool_lit(loc, l != r);
+
+    default:
+      return std::nullopt;
+  }
+}
+
+// bools and null only compare for identity
+static std::optional<ast::Expr>
+fold(Token op, const Location& loc, bool same) {
+  switch(op) {
+    case Token::EQL: return bool_lit(loc, same);
+    case Token::NEQL: return bool_lit(loc, !same);
+
+    default:
+      return std::nullopt;
+  }
+}
+
+static bool
+is_bool(const ast::Expr& e, bool value) {
+  return e.type == ExprType::BOOLLIT && std::get<ast::BoolLit>(e.child).value == value;
+}
+
+Optimizer::Optimizer(Level level)
+  : level(level), program(nullptr) {}
+
+void
+Optimizer::optimize(const ast::ProgramRef& prgm) {
+  if(level == Level::O0) {
+    return;
+  }
+
+  // top level statements are not pruned, the last one's value is what
+  // the repl prints and a return there does not stop the program
+  program = prgm.get();
+  for(const auto& _stmt: prgm->stmts) {
+    stmt(*_stmt);
+  }
+}
+
+void
+Optimizer::stmt(ast::Stmt& _stmt) {
+  switch(_stmt.type) {
+    case StmtType::EXPRESSIONSTMT:
+      expr(*std::get<ast::ExprStmt>(_stmt.child).expr);
+      break;
+
+    case StmtType::LETSTMT:
+      expr(*std::get<ast::LetStmt>(_stmt.child).value);
+      break;
+
+    case StmtType::RETURNSTMT: {
+      auto& ret = std::get<ast::ReturnStmt>(_stmt.child);
+      if(ret.value != nullptr) {
+        expr(*ret.value);
+      }
+      break;
+    }
+
+    case StmtType::IFSTMT:
+      if_stmt(std::get<ast::IfStmt>(_stmt.child));
+      break;
+
+    case StmtType::FORSTMT: {
+      auto& _for = std::get<ast::ForStmt>(_stmt.child);
+      if(_for.pre != nullptr) {
+        stmt(*_for.pre);
+      }
+
+      if(_for.condition != nullptr) {
+        expr(*_for.condition);
+      }
+
+      if(_for.post != nullptr) {
+        expr(*_for.post);
+      }
+
+      // a loop with an empty body is skipped header and all, a body
+      // left with nothing but dead code keeps one dead statement
+      ast::StmtRef first = _for.body->stmts.empty() ? nullptr : _for.body->stmts.front();
+      block_stmt(*_for.body);
+      if(_for.body->stmts.empty() && first != nullptr) {
+        _for.body->stmts.push_back(first);
+      }
+      break;
+    }
+
+    case StmtType::FUNCTIONSTMT:
+      block_stmt(*std::get<ast::FunctionStmt>(_stmt.child).body);
+      break;
+
+    default:
+      break;
+  }
+}
+
+void
+Optimizer::block_stmt(ast::BlockStmt& _stmt) {
+  std::vector<ast::StmtRef> stmts;
+
+  for(const auto& s: _stmt.stmts) {
+    stmt(*s);
+    if(dead(*s)) {
+      continue;
+    }
+
+    stmts.push_back(s);
+    if(returns(*s)) {
+      break;
+    }
+  }
+
+  _stmt.stmts = std::move(stmts);
+}
+
+void
+Optimizer::if_stmt(ast::IfStmt& _stmt) {
+  expr(*_stmt.condition);
+  block_stmt(*_stmt.consequence);
+  if(_stmt.alternative != nullptr) {
+    block_stmt(*_stmt.alternative);
+  }
+
+  if(is_bool(*_stmt.condition, true)) {
+    _stmt.alternative = nullptr;
+    return;
+  }
+
+  // both branches share one scope, so the else branch can take the
+  // place of the one that never runs
+  if(is_bool(*_stmt.condition, false) && _stmt.alternative != nullptr) {
+    std::get<ast::BoolLit>(_stmt.condition->child).value = true;
+    _stmt.consequence = _stmt.alternative;
+    _stmt.alternative = nullptr;
+  }
+}
+
+void
+Optimizer::expr(ast::Expr& _expr) {
+  switch(_expr.type) {
+    case ExprType::ARRAYLIT:
+      for(const auto& e: std::get<ast::ArrayLit>(_expr.child).elements) {
+        expr(*e);
+      }
+      break;
+
+    case ExprType::STRUCTLIT:
+      for(const auto& v: std::get<ast::StructLit>(_expr.child).value) {
+        expr(*v);
+      }
+      break;
+
+    case ExprType::UNARYEXP:
+      unary_expr(_expr);
+      break;
+
+    case ExprType::BINARYEXP:
+      binary_expr(_expr);
+      break;
+
+    case ExprType::ASSIGNMENTEXP: {
+      auto& assign = std::get<ast::AssignmentExpr>(_expr.child);
+      expr(*assign.left);
+      expr(*assign.right);
+      break;
+    }
+
+    case ExprType::OPASSIGNMENTEXP:
+      expr(*std::get<ast::OpAssignmentExpr>(_expr.child).right);
+      break;
+
+    case ExprType::CALLEXP: {
+      auto& call = std::get<ast::CallExpr>(_expr.child);
+      expr(*call.function);
+      for(const auto& arg: call.arguments) {
+        expr(*arg);
+      }
+      break;
+    }
+
+    case ExprType::INDEXEXP: {
+      auto& index = std::get<ast::IndexExpr>(_expr.child);
+      expr(*index.left);
+      expr(*index.index);
+      break;
+    }
+
+    case ExprType::MEMBEREXP:
+      expr(*std::get<ast::MemberExpr>(_expr.child).left);
+      break;
+
+    default:
+      break;
+  }
+}
+
+void
+Optimizer::unary_expr(ast::Expr& _expr) {
+  auto& unary = std::get<ast::UnaryExpr>(_expr.child);
+  expr(*unary.right);
+
+  const ast::Expr& right = *unary.right;
+  Location loc = unary.location;
+  std::optional<ast::Expr> folded;
+
+  if(unary.operator_ == Token::NOT) {
+    // everything but false and null is truthy
+    switch(right.type) {
+      case ExprType::BOOLLIT:
+        folded = bool_lit(loc, !std::get<ast::BoolLit>(right.child).value);
+        break;
+
+      case ExprType::NULLLIT:
+        folded = bool_lit(loc, true);
+        break;
+
+      case ExprType::INTEGERLIT:
+      case ExprType::FLOATLIT:
+      case ExprType::STRINGLIT:
+        folded = bool_lit(loc, false);
+        break;
+
+      default:
+        break;
+    }
+  }
+
+  if(unary.operator_ == Token::SUB) {
+    if(right.type == ExprType::INTEGERLIT) {
+      int64_t value = std::get<ast::IntegerLit>(right.child).value;
+      if(value != std::numeric_limits<int64_t>::min()) {
+        folded = integer_lit(loc, -value);
+      }
+    }
+
+    if(right.type == ExprType::FLOATLIT) {
+      folded = float_lit(loc, -std::get<ast::FloatLit>(right.child).value);
+    }
+  }
+
+  if(folded) {
+    _expr = std::move(*folded);
+  }
+}
+
+void
+Optimizer::binary_expr(ast::Expr& _expr) {
+  auto& binary = std::get<ast::BinaryExpr>(_expr.child);
+  expr(*binary.left);
+  expr(*binary.right);
+
+  const ast::Expr& left = *binary.left;
+  const ast::Expr& right = *binary.right;
+  if(left.type != right.type) {
+    return;
+  }
+
+  Token op = binary.operator_;
+  Location loc = binary.location;
+  std::optional<ast::Expr> folded;
+
+  switch(left.type) {
+    case ExprType::INTEGERLIT:
+      folded = fold(
+        op,
+        loc,
+        std::get<ast::IntegerLit>(left.child).value,
+        std::get<ast::IntegerLit>(right.child).value
+      );
+      break;
+
+    case ExprType::FLOATLIT:
+      folded = fold(
+        op,
+        loc,
+        std::get<ast::FloatLit>(left.child).value,
+        std::get<ast::FloatLit>(right.child).value
+      );
+      break;
+
+    case ExprType::STRINGLIT:
+      folded = fold(
+        op,
+        loc,
+        *std::get<ast::StringLit>(left.child).value,
+        *std::get<ast::StringLit>(right.child).value
+      );
+      break;
+
+    case ExprType::BOOLLIT:
+      folded = fold(
+        op,
+        loc,
+        std::get<ast::BoolLit>(left.child).value == std::get<ast::BoolLit>(right.child).value
+      );
+      break;
+
+    case ExprType::NULLLIT:
+      folded = fold(op, loc, true);
+      break;
+
+    default:
+      break;
+  }
+
+  if(!folded) {
+    return;
+  }
+
+  if(folded->type == ExprType::STRINGLIT) {
+    program->constants.push_back(std::get<ast::StringLit>(folded->child).value);
+  }
+  _expr = std::move(*folded);
+}
+
+bool
+Optimizer::returns(const ast::Stmt& _stmt) const {
+  if(_stmt.type == StmtType::RETURNSTMT) {
+    return true;
+  }
+
+  if(_stmt.type != StmtType::IFSTMT) {
+    return false;
+  }
+
+  // blocks are already cut after their first statement that returns
+  auto ends = [this](const ast::BlockStmtRef& b) {
+    return b != nullptr && !b->stmts.empty() && returns(*b->stmts.back());
+  };
+
+  const auto& _if = std::get<ast::IfStmt>(_stmt.child);
+  return ends(_if.consequence) &&
+    (is_bool(*_if.condition, true) || ends(_if.alternative));
+}
+
+bool
+Optimizer::dead(const ast::Stmt& _stmt) const {
+  if(_stmt.type != StmtType::IFSTMT) {
+    return false;
+  }
+
+  const auto& _if = std::get<ast::IfStmt>(_stmt.child);
+  return is_bool(*_if.condition, false) && _if.alternative == nullptr;
+}
+};
@@ -0,0 +1,49 @@
+/*
+**  Author: Aniket Biswas (xunicatt)
+**  Github: https://github.com/xunicatt
+**  Description: simplifies the tree between parsing and resolving
+**  File: optimizer.h
+*/
+
+#ifndef __OPTIMIZER_H__
+#define __OPTIMIZER_H__
+
+#include <ast.h>
+#include <token.h>
+
+namespace optimizer {
+// -O0 runs the tree as parsed, -O1 runs every pass below
+enum Level {
+  O0 = 0,
+  O1,
+};
+
+// folds operators whose operands are literals, drops the branch of an
+// if that can never run and the statements after one that always
+// returns. anything that would fail at runtime (a division by zero, an
+// overflow, mismatched types) is left alone so it still fails there
+class Optimizer {
+public:
+  Optimizer(Level);
+  void optimize(const ast::ProgramRef&);
+
+private:
+  void stmt(ast::Stmt&);
+  void block_stmt(ast::BlockStmt&);
+  void if_stmt(ast::IfStmt&);
+  void expr(ast::Expr&);
+  void unary_expr(ast::Expr&);
+  void binary_expr(ast::Expr&);
+
+  // true when running the statement always ends the enclosing block
+  bool returns(const ast::Stmt&) const;
+  // true for an if statement whose condition is a false literal and
+  // that has no else, running it does nothing
+  bool dead(const ast::Stmt&) const;
+
+  Level level;
+  ast::Program* program;
+};
+};
+
+#endif
@@ -0,0 +1,140 @@
+#include <algorithm>
+#include <ast.h>
+#include <atomic>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <lexer.h>
+#include <parser.h>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace parser {
+// smaller pieces cost more in threads than they save in parsing
+static constexpr size_t MIN_PIECE = 256 * 1024;
+// pieces per thread, so one slow piece does not hold up the rest
+static constexpr size_t PIECES_PER_JOB = 4;
+
+// keywords of statements that can only start, never continue, a top
+// level statement. an if is left out as else would be cut off
+static constexpr std::string_view cuts[] = {"let", "struct", "func", "extern"};
+
+static bool
+starts_stmt(std::string_view data, size_t i) {
+  for(std::string_view keyword: cuts) {
+    size_t end = i + keyword.size();
+    if(
+      data.substr(i, keyword.size()) == keyword &&
+      end < data.size() &&
+      !std::isalnum(static_cast<unsigned char>(data[end])) &&
+      data[end] != '_'
+    ) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// first line at or after from that begins with one of the keywords in
+// its first column. a cut inside a block or a string leaves a piece that
+// fails to parse and the source is parsed whole instead
+static size_t
+boundary(std::string_view data, size_t from) {
+  while(true) {
+    size_t newline = data.find('\n', from);
+    if(newline == std::string_view::npos) {
+      return data.size();
+    }
+
+    if(starts_stmt(data, newline + 1)) {
+      return newline + 1;
+    }
+    from = newline + 1;
+  }
+}
+
+static ast::ProgramRef
+parse_whole(Lexer& lexer, std::vector<std::string>& errors) {
+  Parser parser(lexer);
+  ast::ProgramRef prgm = parser.parse();
+  errors = parser.errors();
+  return prgm;
+}
+
+ast::ProgramRef
+parse(
+  Lexer& lexer,
+  std::string_view data,
+  size_t jobs,
+  std::vector<std::string>& errors
+) {
+  size_t pieces = std::min(jobs * PIECES_PER_JOB, data.size() / MIN_PIECE);
+  if(jobs < 2 || pieces < 2) {
+    return parse_whole(lexer, errors);
+  }
+
+  std::vector<size_t> offsets = {0};
+  for(size_t i = 1; i < pieces; i++) {
+    size_t at = boundary(data, std::max(offsets.back(), data.size() / pieces * i));
+    if(at == data.size()) {
+      break;
+    }
+    offsets.push_back(at);
+  }
+  offsets.push_back(data.size());
+
+  if(offsets.size() < 3) {
+    return parse_whole(lexer, errors);
+  }
+
+  // every piece is lexed from its own offset up to the next cut, so the
+  // locations in it are offsets into the whole source
+  std::vector<ast::ProgramRef> parts(offsets.size() - 1);
+  std::atomic<size_t> next = 0;
+  std::atomic<bool> failed = false;
+
+  auto work = [&]() {
+    for(size_t i = next++; i < parts.size() && !failed; i = next++) {
+      Lexer piece(lexer.filename(), data.substr(0, offsets[i + 1]));
+      piece.set_location(Location{.offset = static_cast<uint32_t>(offsets[i])});
+
+      Parser parser(piece);
+      parts[i] = parser.parse();
+      if(parts[i] == nullptr) {
+        failed = true;
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for(size_t i = 1; i < std::min(jobs, parts.size()); i++) {
+    threads.emplace_back(work);
+  }
+  work();
+
+  for(auto& thread: threads) {
+    thread.join();
+  }
+
+  if(failed) {
+    return parse_whole(lexer, errors);
+  }
+
+  ast::ProgramRef prgm = std::make_unique<ast::Program>();
+  for(auto& part: parts) {
+    prgm->stmts.insert(prgm->stmts.end(), part->stmts.begin(), part->stmts.end());
+    for(auto& constant: part->constants) {
+      prgm->constants.push_back(std::move(constant));
+    }
+    part->stmts.clear();
+    part->constants.clear();
+    prgm->parts.push_back(std::move(part));
+  }
+
+  return prgm;
+}
+};
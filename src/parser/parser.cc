@@ -1,9 +1,10 @@
+#include <array>
 #include <cstdint>
-#include <functional>
 #include <memory>
 #include <optional>
 #include <parser.h>
 #include <string>
+#include <string_view>
 #include <token.h>
 #include <lexer.h>
 #include <ast.h>
@@ -12,41 +13,74 @@
 #include <map>
 #include <print>
 
-#define TO_UNARY_FN(fn) [this](void) { return this->fn(); }
-#define TO_BINARY_FN(fn) [this](ast::ExprRef left) { return this->fn(std::move(left)); }
-
 using token::Token;
 using ast::ExprType;
 using ast::StmtType;
 
-using UnaryParseFn = std::function<ast::ExprRef(void)>;
-using BinaryParseFn = std::function<ast::ExprRef(ast::ExprRef)>;
-
 namespace parser {
-static std::map<Token, UnaryParseFn> unaryfns;
-static std::map<Token, BinaryParseFn> binaryfns;
-
-static const std::map<Token, parser::Precedence> precedences = {
-  {Token::ASS, Precedence::ASSIGNMENT},
-  {Token::ADAS, Precedence::ASSIGNMENT},
-  {Token::SBAS, Precedence::ASSIGNMENT},
-  {Token::MLAS, Precedence::ASSIGNMENT},
-  {Token::DVAS, Precedence::ASSIGNMENT},
-  {Token::EQL, Precedence::EQUALS},
-  {Token::NEQL, Precedence::EQUALS},
-  {Token::LES, Precedence::LESSGREATER},
-  {Token::LEE, Precedence::LESSGREATER},
-  {Token::GRT, Precedence::LESSGREATER},
-  {Token::GRE, Precedence::LESSGREATER},
-  {Token::ADD, Precedence::SUM},
-  {Token::SUB, Precedence::SUM},
-  {Token::DIV, Precedence::PRODUCT},
-  {Token::MUL, Precedence::PRODUCT},
-  {Token::LPAREN, Precedence::CALL},
-  {Token::LCURLY, Precedence::CALL},
-  {Token::LSQR, Precedence::INDEX},
-  {Token::DOT, Precedence::INDEX},
-};
+static constexpr std::array<Precedence, Token::__TOKENCOUNT__> precedences = [] {
+  std::array<Precedence, Token::__TOKENCOUNT__> p = {};
+  p.fill(Precedence::LOWEST);
+  p[Token::ASS] = Precedence::ASSIGNMENT;
+  p[Token::ADAS] = Precedence::ASSIGNMENT;
+  p[Token::SBAS] = Precedence::ASSIGNMENT;
+  p[Token::MLAS] = Precedence::ASSIGNMENT;
+  p[Token::DVAS] = Precedence::ASSIGNMENT;
+  p[Token::EQL] = Precedence::EQUALS;
+  p[Token::NEQL] = Precedence::EQUALS;
+  p[Token::LES] = Precedence::LESSGREATER;
+  p[Token::LEE] = Precedence::LESSGREATER;
+  p[Token::GRT] = Precedence::LESSGREATER;
+  p[Token::GRE] = Precedence::LESSGREATER;
+  p[Token::ADD] = Precedence::SUM;
+  p[Token::SUB] = Precedence::SUM;
+  p[Token::DIV] = Precedence::PRODUCT;
+  p[Token::MUL] = Precedence::PRODUCT;
+  p[Token::LPAREN] = Precedence::CALL;
+  p[Token::LCURLY] = Precedence::CALL;
+  p[Token::LSQR] = Precedence::INDEX;
+  p[Token::DOT] = Precedence::INDEX;
+  return p;
+}();
+
+constexpr std::array<Parser::UnaryParseFn, Token::__TOKENCOUNT__> Parser::unaryfns = [] {
+  std::array<UnaryParseFn, Token::__TOKENCOUNT__> fns = {};
+  fns[Token::IDENTIFIER] = &Parser::ident_expr;
+  fns[Token::NULL_] = &Parser::null_lit;
+  fns[Token::INTLIT] = &Parser::integer_lit;
+  fns[Token::FLOATLIT] = &Parser::float_lit;
+  fns[Token::BOOLLIT] = &Parser::bool_lit;
+  fns[Token::STRINGLIT] = &Parser::string_lit;
+  fns[Token::LSQR] = &Parser::array_lit;
+  fns[Token::NOT] = &Parser::unary_expr;
+  fns[Token::SUB] = &Parser::unary_expr;
+  fns[Token::LPAREN] = &Parser::grouped_expr;
+  return fns;
+}();
+
+constexpr std::array<Parser::BinaryParseFn, Token::__TOKENCOUNT__> Parser::binaryfns = [] {
+  std::array<BinaryParseFn, Token::__TOKENCOUNT__> fns = {};
+  fns[Token::ADD] = &Parser::binary_expr;
+  fns[Token::SUB] = &Parser::binary_expr;
+  fns[Token::MUL] = &Parser::binary_expr;
+  fns[Token::DIV] = &Parser::binary_expr;
+  fns[Token::EQL] = &Parser::binary_expr;
+  fns[Token::NEQL] = &Parser::binary_expr;
+  fns[Token::LES] = &Parser::binary_expr;
+  fns[Token::LEE] = &Parser::binary_expr;
+  fns[Token::GRT] = &Parser::binary_expr;
+  fns[Token::GRE] = &Parser::binary_expr;
+  fns[Token::LCURLY] = &Parser::struct_lit;
+  fns[Token::ASS] = &Parser::assignment_expr;
+  fns[Token::ADAS] = &Parser::opassignment_expr;
+  fns[Token::SBAS] = &Parser::opassignment_expr;
+  fns[Token::MLAS] = &Parser::opassignment_expr;
+  fns[Token::DVAS] = &Parser::opassignment_expr;
+  fns[Token::LSQR] = &Parser::index_expr;
+  fns[Token::LPAREN] = &Parser::call_expr;
+  fns[Token::DOT] = &Parser::member_expr;
+  return fns;
+}();
 
 static const std::map<Token, Token> opassignment = {
   {Token::ADAS, Token::ADD},
@@ -62,41 +96,7 @@ is_a_type(Token t) {
 }
 
 Parser::Parser(Lexer& lexer)
-  : lexer(lexer) {
-  unaryfns[Token::IDENTIFIER] = TO_UNARY_FN(ident_expr);
-  unaryfns[Token::NULL_] = TO_UNARY_FN(null_lit);
-  unaryfns[Token::INTLIT] = TO_UNARY_FN(integer_lit);
-  unaryfns[Token::FLOATLIT] = TO_UNARY_FN(float_lit);
-  unaryfns[Token::BOOLLIT] = TO_UNARY_FN(bool_lit);
-  unaryfns[Token::STRINGLIT] = TO_UNARY_FN(string_lit);
-  unaryfns[Token::LSQR] = TO_UNARY_FN(array_lit);
-
-  auto unary_expr = TO_UNARY_FN(unary_expr);
-  unaryfns[Token::NOT] = unary_expr;
-  unaryfns[Token::SUB] = unary_expr;
-  unaryfns[Token::LPAREN] = TO_UNARY_FN(grouped_expr);
-
-  auto binary_expr = TO_BINARY_FN(binary_expr);
-  binaryfns[Token::ADD] = binary_expr;
-  binaryfns[Token::SUB] = binary_expr;
-  binaryfns[Token::MUL] = binary_expr;
-  binaryfns[Token::DIV] = binary_expr;
-  binaryfns[Token::EQL] = binary_expr;
-  binaryfns[Token::NEQL] = binary_expr;
-  binaryfns[Token::LES] = binary_expr;
-  binaryfns[Token::LEE] = binary_expr;
-  binaryfns[Token::GRT] = binary_expr;
-  binaryfns[Token::GRE] = binary_expr;
-
-  binaryfns[Token::LCURLY] = TO_BINARY_FN(struct_lit);
-  binaryfns[Token::ASS] = TO_BINARY_FN(assignment_expr);
-  binaryfns[Token::ADAS] = TO_BINARY_FN(opassignment_expr);
-  binaryfns[Token::SBAS] = TO_BINARY_FN(opassignment_expr);
-  binaryfns[Token::MLAS] = TO_BINARY_FN(opassignment_expr);
-  binaryfns[Token::DVAS] = TO_BINARY_FN(opassignment_expr);
-  binaryfns[Token::LSQR] = TO_BINARY_FN(index_expr);
-  binaryfns[Token::LPAREN] = TO_BINARY_FN(call_expr);
-  binaryfns[Token::DOT] = TO_BINARY_FN(member_expr);
+  : tokens(lexer) {
 }
 
 const std::vector<std::string>&
@@ -104,12 +104,18 @@ Parser::errors() {
   return _errors;
 }
 
+template<typename T>
+inline T*
+Parser::make(T&& node) {
+  return program->arena.make(std::move(node));
+}
+
 ast::ProgramRef
 Parser::parse() {
-  ast::ProgramRef prgm = std::make_unique<ast::Program>();
+  program = std::make_unique<ast::Program>();
 
-  while(lexer.next_token() != Token::EOF_) {
-    if(lexer.last_token() == Token::ERROR) {
+  while(tokens.next_token() != Token::EOF_) {
+    if(tokens.last_token() == Token::ERROR) {
       error("unknown token");
       return nullptr;
     }
@@ -119,27 +125,31 @@ Parser::parse() {
       return nullptr;
     }
 
-    prgm->stmts.push_back(std::move(_stmt));
+    program->stmts.push_back(_stmt);
   }
 
-  return prgm;
+  for(const auto& [_, constant]: constants) {
+    program->constants.push_back(constant);
+  }
+
+  return std::move(program);
 }
 
 inline void
 Parser::error(const std::string& msg) {
-  error(msg, lexer.location());
+  error(msg, tokens.location());
 }
 
 inline void
 Parser::error(const std::string& msg, const Location& loc) {
-  _errors.push_back(lexer.fmt_error(loc, msg));
+  _errors.push_back(tokens.fmt_error(loc, msg));
 }
 
 ast::StmtRef
 Parser::stmt() {
-  ast::StmtRef stmt;
+  ast::StmtRef stmt = nullptr;
 
-  switch(lexer.last_token()) {
+  switch(tokens.last_token()) {
   case Token::LET:
     stmt = let_stmt();
     break;
@@ -168,93 +178,93 @@ Parser::stmt() {
     stmt = expr_stmt();
   }
 
-  if(lexer.peek_token() != Token::SEMICOLON) {
+  if(tokens.peek_token() != Token::SEMICOLON) {
     error("expected ;");
     return nullptr;
   }
-  lexer.next_token();
+  tokens.next_token();
 
   return stmt;
 }
 
 ast::StmtRef
 Parser::struct_stmt() {
-  if(lexer.peek_token() != Token::IDENTIFIER) {
+  if(tokens.peek_token() != Token::IDENTIFIER) {
     error("expected identifier");
     return nullptr;
   }
 
-  lexer.next_token();
-  ast::IdentifierRef name = std::make_unique<ast::Identifier>(ast::Identifier{
-    .location = lexer.last_location(),
-    .value = std::get<std::string>(lexer.get_value())
+  tokens.next_token();
+  ast::IdentifierRef name = make(ast::Identifier{
+    .location = tokens.last_location(),
+    .value = std::string(std::get<std::string_view>(tokens.get_value()))
   });
 
-  if(lexer.peek_token() != Token::LCURLY) {
+  if(tokens.peek_token() != Token::LCURLY) {
     error("expected {");
     return nullptr;
   }
-  lexer.next_token();
+  tokens.next_token();
 
   std::vector<ast::IdentifierRef> types;
   std::vector<ast::IdentifierRef> names;
-  if(lexer.peek_token() != Token::RCURLY) {
+  if(tokens.peek_token() != Token::RCURLY) {
     while(true) {
-      if(lexer.peek_token() != Token::IDENTIFIER) {
+      if(tokens.peek_token() != Token::IDENTIFIER) {
         error("expected an identifier");
         return nullptr;
       }
 
-      lexer.next_token();
+      tokens.next_token();
       names.push_back(
-        std::make_unique<ast::Identifier>(ast::Identifier{
-          .location = lexer.last_location(),
-          .value = std::get<std::string>(lexer.get_value())
+        make(ast::Identifier{
+          .location = tokens.last_location(),
+          .value = std::string(std::get<std::string_view>(tokens.get_value()))
         })
       );
 
-      if(lexer.peek_token() != Token::COLON) {
+      if(tokens.peek_token() != Token::COLON) {
         error("expected :");
         return nullptr;
       }
-      lexer.next_token();
+      tokens.next_token();
 
-      if(!is_a_type(lexer.peek_token()) && lexer.peek_token() != Token::IDENTIFIER) {
+      if(!is_a_type(tokens.peek_token()) && tokens.peek_token() != Token::IDENTIFIER) {
         error("expected a type");
         return nullptr;
       }
-      lexer.next_token();
+      tokens.next_token();
 
       types.push_back(
-        std::make_unique<ast::Identifier>(ast::Identifier{
-          .location = lexer.last_location(),
-          .value = std::get<std::string>(lexer.get_value())
+        make(ast::Identifier{
+          .location = tokens.last_location(),
+          .value = std::string(std::get<std::string_view>(tokens.get_value()))
         })
       );
 
-      if(lexer.peek_token() == Token::RCURLY) {
+      if(tokens.peek_token() == Token::RCURLY) {
         break;
       }
 
-      if(lexer.peek_token() != Token::COMMA) {
+      if(tokens.peek_token() != Token::COMMA) {
         error("expected , or }");
         return nullptr;
       }
 
-      lexer.next_token();
+      tokens.next_token();
     }
   }
 
-  if(lexer.peek_token() != Token::RCURLY) {
+  if(tokens.peek_token() != Token::RCURLY) {
     error("expected }");
     return nullptr;
   }
-  lexer.next_token();
+  tokens.next_token();
 
-  return std::make_unique<ast::Stmt>(ast::Stmt{
+  return make(ast::Stmt{
     .type = StmtType::STRUCTSTMT,
     .child = ast::StructStmt{
-      .name = std::move(name),
+      .name = name,
       .types = std::move(types),
       .names = std::move(names),
     }
@@ -264,33 +274,33 @@ Parser::struct_stmt() {
 ast::StmtRef
 Parser::let_stmt() {
   //let x = <expr>
-  if(lexer.peek_token() != Token::IDENTIFIER) {
+  if(tokens.peek_token() != Token::IDENTIFIER) {
     error("expected identifier");
     return nullptr;
   }
 
-  lexer.next_token();
-  ast::IdentifierRef name = std::make_unique<ast::Identifier>(ast::Identifier{
-    lexer.last_location(), std::get<std::string>(lexer.get_value())
+  tokens.next_token();
+  ast::IdentifierRef name = make(ast::Identifier{
+    tokens.last_location(), std::string(std::get<std::string_view>(tokens.get_value()))
   });
 
-  if(lexer.peek_token() != Token::ASS) {
+  if(tokens.peek_token() != Token::ASS) {
     error("a variable must be initialized with a value");
     return nullptr;
   }
 
-  lexer.next_token();
-  lexer.next_token();
+  tokens.next_token();
+  tokens.next_token();
 
-  ast::ExprRef value;
+  ast::ExprRef value = nullptr;
   if((value = expr(Precedence::LOWEST)) == nullptr) {
     return nullptr;
   }
 
-  return std::make_unique<ast::Stmt>(ast::Stmt{
+  return make(ast::Stmt{
     .type = StmtType::LETSTMT, .child = ast::LetStmt{
-      .name = std::move(name),
-      .value = std::move(value)
+      .name = name,
+      .value = value
     }
   });
 }
@@ -298,217 +308,217 @@ Parser::let_stmt() {
 ast::StmtRef
 Parser::return_stmt() {
   //return or return <expr>
-  ast::ExprRef value;
-  if(lexer.peek_token() != Token::SEMICOLON) {
-    lexer.next_token(); //fetch token
+  ast::ExprRef value = nullptr;
+  if(tokens.peek_token() != Token::SEMICOLON) {
+    tokens.next_token(); //fetch token
     value = expr(Precedence::LOWEST);
   }
 
-  return std::make_unique<ast::Stmt>(ast::Stmt{
+  return make(ast::Stmt{
     .type = StmtType::RETURNSTMT,
     .child = ast::ReturnStmt{
-      .value = std::move(value)
+      .value = value
     }
   });
 }
 
 ast::StmtRef
 Parser::if_stmt() {
-  if(lexer.peek_token() != Token::LPAREN) {
+  if(tokens.peek_token() != Token::LPAREN) {
     error("expected (");
     return nullptr;
   }
-  lexer.next_token();
+  tokens.next_token();
 
-  lexer.next_token();
+  tokens.next_token();
   ast::ExprRef condition = expr(Precedence::LOWEST);
   if(condition == nullptr) {
     return nullptr;
   }
 
-  if(lexer.peek_token() != Token::RPAREN) {
+  if(tokens.peek_token() != Token::RPAREN) {
     error("expected )");
     return nullptr;
   }
-  lexer.next_token();
+  tokens.next_token();
 
-  if(lexer.peek_token() != Token::LCURLY) {
+  if(tokens.peek_token() != Token::LCURLY) {
     error("expected {");
     return nullptr;
   }
-  lexer.next_token();
+  tokens.next_token();
 
   ast::BlockStmtRef consequence = block_stmt();
   if(consequence == nullptr) {
     return nullptr;
   }
 
-  ast::BlockStmtRef alternative;
-  if(lexer.peek_token() == Token::ELSE) {
-    lexer.next_token();
+  ast::BlockStmtRef alternative = nullptr;
+  if(tokens.peek_token() == Token::ELSE) {
+    tokens.next_token();
 
-    if(lexer.peek_token() != Token::LCURLY) {
+    if(tokens.peek_token() != Token::LCURLY) {
       error("expected {");
       return nullptr;
     }
-    lexer.next_token();
+    tokens.next_token();
 
     if((alternative = block_stmt()) == nullptr) {
       return nullptr;
     }
   }
 
-  return std::make_unique<ast::Stmt>(ast::Stmt{
+  return make(ast::Stmt{
     .type = StmtType::IFSTMT,
     .child = ast::IfStmt{
-      .condition = std::move(condition),
-      .consequence = std::move(consequence),
-      .alternative = std::move(alternative)
+      .condition = condition,
+      .consequence = consequence,
+      .alternative = alternative
     }
   });
 }
 
 ast::StmtRef
 Parser::for_stmt() {
-  ast::StmtRef pre;
-  if(lexer.peek_token() != Token::LPAREN) {
+  ast::StmtRef pre = nullptr;
+  if(tokens.peek_token() != Token::LPAREN) {
     error("expected (");
     return nullptr;
   }
-  lexer.next_token();
+  tokens.next_token();
 
-  if(lexer.peek_token() != Token::SEMICOLON) {
-    lexer.next_token();
+  if(tokens.peek_token() != Token::SEMICOLON) {
+    tokens.next_token();
     if((pre = stmt()) == nullptr) {
       return nullptr;
     }
   } else {
-    lexer.next_token();
+    tokens.next_token();
   }
 
 
-  ast::ExprRef condition;
-  if(lexer.peek_token() != Token::SEMICOLON) {
-    lexer.next_token();
+  ast::ExprRef condition = nullptr;
+  if(tokens.peek_token() != Token::SEMICOLON) {
+    tokens.next_token();
     if((condition = expr(Precedence::LOWEST)) == nullptr) {
       return nullptr;
     }
   }
 
-  if(lexer.peek_token() != Token::SEMICOLON) {
+  if(tokens.peek_token() != Token::SEMICOLON) {
     error("expected ;");
     return nullptr;
   }
-  lexer.next_token();
+  tokens.next_token();
 
-  ast::ExprRef post;
-  if(lexer.peek_token() != Token::RPAREN) {
-    lexer.next_token();
+  ast::ExprRef post = nullptr;
+  if(tokens.peek_token() != Token::RPAREN) {
+    tokens.next_token();
     if((post = expr(Precedence::LOWEST)) == nullptr) {
       return nullptr;
     }
   }
 
-  if(lexer.peek_token() != Token::RPAREN) {
+  if(tokens.peek_token() != Token::RPAREN) {
     error("expected )");
     return nullptr;
   }
-  lexer.next_token();
+  tokens.next_token();
 
-  if(lexer.peek_token() != Token::LCURLY) {
+  if(tokens.peek_token() != Token::LCURLY) {
     error("expected {");
     return nullptr;
   }
-  lexer.next_token();
+  tokens.next_token();
 
   ast::BlockStmtRef body = block_stmt();
   if(body == nullptr) {
     return nullptr;
   }
 
-  return std::make_unique<ast::Stmt>(ast::Stmt{
+  return make(ast::Stmt{
     .type = StmtType::FORSTMT,
     .child = ast::ForStmt{
-      .pre = std::move(pre),
-      .condition = std::move(condition),
-      .post = std::move(post),
-      .body = std::move(body)
+      .pre = pre,
+      .condition = condition,
+      .post = post,
+      .body = body
     }
   });
 }
 
 ast::StmtRef
 Parser::func_stmt() {
-  if(lexer.peek_token() != Token::IDENTIFIER) {
+  if(tokens.peek_token() != Token::IDENTIFIER) {
     error("expected identifier");
     return nullptr;
   }
-  lexer.next_token();
+  tokens.next_token();
 
-  ast::IdentifierRef name = std::make_unique<ast::Identifier>(ast::Identifier{
-    .location = lexer.last_location(),
-    .value = std::get<std::string>(lexer.get_value())
+  ast::IdentifierRef name = make(ast::Identifier{
+    .location = tokens.last_location(),
+    .value = std::string(std::get<std::string_view>(tokens.get_value()))
   });
 
-  if(lexer.peek_token() != Token::LPAREN) {
+  if(tokens.peek_token() != Token::LPAREN) {
     error("expected (");
     return nullptr;
   }
-  lexer.next_token();
+  tokens.next_token();
 
   std::vector<ast::IdentifierRef> paramenters;
 
-  if(lexer.peek_token() != Token::RPAREN) {
+  if(tokens.peek_token() != Token::RPAREN) {
     while(true) {
-      if(lexer.peek_token() != Token::IDENTIFIER) {
+      if(tokens.peek_token() != Token::IDENTIFIER) {
         error("expected an identifier");
         return nullptr;
       }
 
-      lexer.next_token();
+      tokens.next_token();
       paramenters.push_back(
-        std::make_unique<ast::Identifier>(ast::Identifier{
-          .location = lexer.last_location(),
-          .value = std::get<std::string>(lexer.get_value())
+        make(ast::Identifier{
+          .location = tokens.last_location(),
+          .value = std::string(std::get<std::string_view>(tokens.get_value()))
         })
       );
 
-      if(lexer.peek_token() == Token::RPAREN) {
+      if(tokens.peek_token() == Token::RPAREN) {
         break;
       }
 
-      if(lexer.peek_token() != Token::COMMA) {
+      if(tokens.peek_token() != Token::COMMA) {
         error("expected , or )");
         return nullptr;
       }
 
-      lexer.next_token();
+      tokens.next_token();
     }
   }
 
-  if(lexer.peek_token() != Token::RPAREN) {
+  if(tokens.peek_token() != Token::RPAREN) {
     error("expected )");
     return nullptr;
   }
-  lexer.next_token();
+  tokens.next_token();
 
-  if(lexer.peek_token() != Token::LCURLY) {
+  if(tokens.peek_token() != Token::LCURLY) {
     error("expected {");
     return nullptr;
   }
-  lexer.next_token();
+  tokens.next_token();
 
   ast::BlockStmtRef body = block_stmt();
   if(body == nullptr) {
     return nullptr;
   }
 
-  return std::make_unique<ast::Stmt>(ast::Stmt{
+  return make(ast::Stmt{
     .type = StmtType::FUNCTIONSTMT,
     .child = ast::FunctionStmt{
-      .name = std::move(name),
+      .name = name,
       .parameters = std::move(paramenters),
-      .body = std::move(body)
+      .body = body
     }
   });
 }
@@ -516,50 +526,50 @@ Parser::func_stmt() {
 ast::StmtRef
 Parser::extern_stmt() {
   //extern <libname> func <funcname> (<args-types>): <return-type>
-  if(lexer.peek_token() != Token::IDENTIFIER) {
+  if(tokens.peek_token() != Token::IDENTIFIER) {
     error("expected library name");
     return nullptr;
   }
 
-  lexer.next_token();
-  ast::IdentifierRef libname = std::make_unique<ast::Identifier>(ast::Identifier{
-    lexer.last_location(),
-    std::get<std::string>(lexer.get_value())
+  tokens.next_token();
+  ast::IdentifierRef libname = make(ast::Identifier{
+    tokens.last_location(),
+    std::string(std::get<std::string_view>(tokens.get_value()))
   });
 
-  if(lexer.peek_token() != Token::FUNC) {
+  if(tokens.peek_token() != Token::FUNC) {
     error("expected 'func'");
     return nullptr;
   }
 
-  lexer.next_token();
-  if(lexer.peek_token() != Token::IDENTIFIER) {
+  tokens.next_token();
+  if(tokens.peek_token() != Token::IDENTIFIER) {
     error("expected function name");
     return nullptr;
   }
 
-  lexer.next_token();
-  ast::IdentifierRef funcname = std::make_unique<ast::Identifier>(ast::Identifier {
-    lexer.last_location(),
-    std::get<std::string>(lexer.get_value())
+  tokens.next_token();
+  ast::IdentifierRef funcname = make(ast::Identifier {
+    tokens.last_location(),
+    std::string(std::get<std::string_view>(tokens.get_value()))
   });
 
-  if(lexer.peek_token() != Token::LPAREN) {
+  if(tokens.peek_token() != Token::LPAREN) {
     error("expected (");
     return nullptr;
   }
 
   std::vector<Token> argtypes;
 
-  lexer.next_token();
-  if(lexer.peek_token() != Token::RPAREN) {
+  tokens.next_token();
+  if(tokens.peek_token() != Token::RPAREN) {
     while(true) {
-      Token argtype = lexer.peek_token();
+      Token argtype = tokens.peek_token();
       if(argtype == Token::VARIADIC) {
-        lexer.next_token();
+        tokens.next_token();
         argtypes.push_back(argtype);
 
-        if(lexer.peek_token() != Token::RPAREN) {
+        if(tokens.peek_token() != Token::RPAREN) {
           error("expected )");
           return nullptr;
         }
@@ -572,42 +582,42 @@ Parser::extern_stmt() {
         return nullptr;
       }
 
-      lexer.next_token();
+      tokens.next_token();
       argtypes.push_back(argtype);
 
-      if(lexer.peek_token() == Token::RPAREN) {
+      if(tokens.peek_token() == Token::RPAREN) {
         break;
       }
 
-      if(lexer.peek_token() != Token::COMMA) {
+      if(tokens.peek_token() != Token::COMMA) {
         error("expected , or )");
         return nullptr;
       }
 
-      lexer.next_token();
+      tokens.next_token();
     }
   }
 
-  lexer.next_token();
+  tokens.next_token();
 
-  if(lexer.peek_token() != Token::COLON) {
+  if(tokens.peek_token() != Token::COLON) {
     error("expected :");
     return nullptr;
   }
 
-  lexer.next_token();
-  if(!is_a_type(lexer.peek_token()) && lexer.peek_token() != Token::VOID) {
+  tokens.next_token();
+  if(!is_a_type(tokens.peek_token()) && tokens.peek_token() != Token::VOID) {
     error("expected a return type");
     return nullptr;
   }
 
-  Token rettype = lexer.next_token();
+  Token rettype = tokens.next_token();
 
-  return std::make_unique<ast::Stmt>(ast::Stmt{
+  return make(ast::Stmt{
     .type = StmtType::EXTERNSTMT,
     .child = ast::ExternStmt{
-      .libname = std::move(libname),
-      .funcname = std::move(funcname),
+      .libname = libname,
+      .funcname = funcname,
       .argtypes = argtypes,
       .rettype = rettype
     }
@@ -621,26 +631,26 @@ Parser::expr_stmt() {
     return nullptr;
   }
 
-  return std::make_unique<ast::Stmt>(ast::Stmt{
+  return make(ast::Stmt{
     .type = StmtType::EXPRESSIONSTMT,
     .child = ast::ExprStmt{
-      .expr = std::move(_expr)
+      .expr = _expr
     }
   });
 }
 
 ast::BlockStmtRef
 Parser::block_stmt() {
-  lexer.next_token();
+  tokens.next_token();
   std::vector<ast::StmtRef> stmts;
 
   while(true) {
-    if(lexer.last_token() == Token::EOF_) {
+    if(tokens.last_token() == Token::EOF_) {
       error("expected }");
       return nullptr;
     }
 
-    if(lexer.last_token() == Token::RCURLY) {
+    if(tokens.last_token() == Token::RCURLY) {
       break;
     }
 
@@ -649,11 +659,11 @@ Parser::block_stmt() {
       return nullptr;
     }
 
-    stmts.push_back(std::move(_stmt));
-    lexer.next_token();
+    stmts.push_back(_stmt);
+    tokens.next_token();
   }
 
-  return std::make_unique<ast::BlockStmt>(ast::BlockStmt{
+  return make(ast::BlockStmt{
     .stmts = std::move(stmts)
   });
 }
@@ -661,24 +671,25 @@ Parser::block_stmt() {
 
 ast::ExprRef
 Parser::expr(Precedence p) {
-  if(!unaryfns.contains(lexer.last_token())) {
-    error("unknown unary operator", lexer.last_location());
+  UnaryParseFn ufn = unaryfns[tokens.last_token()];
+  if(ufn == nullptr) {
+    error("unknown unary operator", tokens.last_location());
     return nullptr;
   }
 
-  UnaryParseFn ufn = unaryfns[lexer.last_token()];
-  ast::ExprRef left = ufn();
+  ast::ExprRef left = (this->*ufn)();
   if(left == nullptr) {
     return nullptr;
   }
 
-  while(lexer.peek_token() != Token::SEMICOLON && p < peek_precedence()) {
-    if(!binaryfns.contains(lexer.peek_token())) {
+  while(tokens.peek_token() != Token::SEMICOLON && p < peek_precedence()) {
+    BinaryParseFn bfn = binaryfns[tokens.peek_token()];
+    if(bfn == nullptr) {
       return left;
     }
 
-    BinaryParseFn bfn = binaryfns[lexer.next_token()];
-    if((left = bfn(std::move(left))) == nullptr) {
+    tokens.next_token();
+    if((left = (this->*bfn)(left)) == nullptr) {
       return nullptr;
     }
   }
@@ -688,69 +699,69 @@ Parser::expr(Precedence p) {
 
 ast::ExprRef
 Parser::unary_expr() {
-  const Location loc = lexer.last_location();
-  const Token& operator_ = lexer.last_token();
+  const Location loc = tokens.last_location();
+  const Token& operator_ = tokens.last_token();
 
-  lexer.next_token();
+  tokens.next_token();
   ast::ExprRef right = expr(Precedence::PREFIX);
   if(right == nullptr) {
     return nullptr;
   }
 
-  return std::make_unique<ast::Expr>(ast::Expr{
+  return make(ast::Expr{
     .type = ExprType::UNARYEXP,
     .child = ast::UnaryExpr{
       .location = loc,
       .operator_ = operator_,
-      .right = std::move(right)
+      .right = right
     }
   });
 }
 
 ast::ExprRef
 Parser::binary_expr(ast::ExprRef left) {
-  const Location loc = lexer.last_location();
-  const Token& operator_ = lexer.last_token();
+  const Location loc = tokens.last_location();
+  const Token& operator_ = tokens.last_token();
   const Precedence& prec = current_precedence();
 
-  lexer.next_token();
+  tokens.next_token();
   ast::ExprRef right = expr(prec);
   if(right == nullptr) {
     return nullptr;
   }
 
-  return std::make_unique<ast::Expr>(ast::Expr{
+  return make(ast::Expr{
     .type = ExprType::BINARYEXP,
     .child = ast::BinaryExpr{
       .location = loc,
       .operator_ = operator_,
-      .left = std::move(left),
-      .right = std::move(right)
+      .left = left,
+      .right = right
     }
   });
 }
 
 ast::ExprRef
 Parser::grouped_expr() {
-  lexer.next_token();
+  tokens.next_token();
   ast::ExprRef _expr = expr(Precedence::LOWEST);
   if(_expr == nullptr) {
     return nullptr;
   }
 
-  if(lexer.peek_token() != Token::RPAREN) {
+  if(tokens.peek_token() != Token::RPAREN) {
     error("expected )");
     return nullptr;
   }
 
-  lexer.next_token();
+  tokens.next_token();
   return _expr;
 }
 
 std::optional<std::vector<ast::ExprRef>>
 Parser::list_expr(const token::Token& end) {
   std::vector<ast::ExprRef> exprs;
-  if(lexer.next_token() == end) {
+  if(tokens.next_token() == end) {
     return exprs;
   }
 
@@ -760,17 +771,17 @@ Parser::list_expr(const token::Token& end) {
       return std::nullopt;
     }
 
-    exprs.push_back(std::move(_expr));
-    if(lexer.next_token() == end) {
+    exprs.push_back(_expr);
+    if(tokens.next_token() == end) {
       break;
     }
 
-    if(lexer.last_token() != Token::COMMA) {
+    if(tokens.last_token() != Token::COMMA) {
       error("expected , or )");
       return std::nullopt;
     }
 
-    lexer.next_token();
+    tokens.next_token();
   }
 
   return exprs;
@@ -778,67 +789,73 @@ Parser::list_expr(const token::Token& end) {
 
 ast::ExprRef
 Parser::null_lit() {
-  return std::make_unique<ast::Expr>(ast::Expr{
+  return make(ast::Expr{
     .type = ast::NULLLIT,
     .child = ast::NullLit{
-      .location = lexer.last_location()
+      .location = tokens.last_location()
     }
   });
 }
 
 ast::ExprRef
 Parser::integer_lit() {
-  return std::make_unique<ast::Expr>(ast::Expr{
+  return make(ast::Expr{
     .type = ast::INTEGERLIT,
     .child = ast::IntegerLit{
-      .location = lexer.last_location(),
-      .value = std::get<int64_t>(lexer.get_value())
+      .location = tokens.last_location(),
+      .value = std::get<int64_t>(tokens.get_value())
     }
   });
 }
 
 ast::ExprRef
 Parser::float_lit() {
-  return std::make_unique<ast::Expr>(ast::Expr{
+  return make(ast::Expr{
     .type = ast::FLOATLIT,
     .child = ast::FloatLit{
-      .location = lexer.last_location(),
-      .value = std::get<double>(lexer.get_value())
+      .location = tokens.last_location(),
+      .value = std::get<double>(tokens.get_value())
     }
   });
 }
 
 ast::ExprRef
 Parser::bool_lit() {
-  return std::make_unique<ast::Expr>(ast::Expr{
+  return make(ast::Expr{
     .type = ast::BOOLLIT,
     .child = ast::BoolLit{
-      .location = lexer.last_location(),
-      .value = std::get<bool>(lexer.get_value())
+      .location = tokens.last_location(),
+      .value = std::get<bool>(tokens.get_value())
     }
   });
 }
 
 ast::ExprRef
 Parser::string_lit() {
-  return std::make_unique<ast::Expr>(ast::Expr{
+  std::string value = unescape(std::get<std::string_view>(tokens.get_value()));
+  ast::Constant& constant = constants[value];
+  if(constant == nullptr) {
+    constant = std::make_shared<std::string>(std::move(value));
+  }
+
+  return make(ast::Expr{
     .type = ast::STRINGLIT,
     .child = ast::StringLit{
-      .location = lexer.last_location(),
-      .value = std::get<std::string>(lexer.get_value())
+      .location = tokens.last_location(),
+      .value = constant
     }
   });
 }
 
 ast::ExprRef
 Parser::array_lit() {
-  const Location loc = lexer.last_location();
+  const Location loc = tokens.last_location();
   auto elements = list_expr(Token::RSQR);
   if(!elements.has_value()) {
     return nullptr;
   }
 
-  return std::make_unique<ast::Expr>(ast::Expr{
+  return make(ast::Expr{
     .type = ExprType::ARRAYLIT,
     .child = ast::ArrayLit{
       .location = loc,
@@ -851,53 +868,53 @@ ast::ExprRef
 Parser::struct_lit(ast::ExprRef name) {
   std::vector<ast::ExprRef> values;
   std::vector<ast::IdentifierRef> names;
-  if(lexer.peek_token() != Token::RCURLY) {
+  if(tokens.peek_token() != Token::RCURLY) {
     while(true) {
-      if(lexer.peek_token() != Token::IDENTIFIER) {
+      if(tokens.peek_token() != Token::IDENTIFIER) {
         error("expected an identifier");
         return nullptr;
       }
 
-      lexer.next_token();
+      tokens.next_token();
       names.push_back(
-        std::make_unique<ast::Identifier>(ast::Identifier{
-          .location = lexer.last_location(),
-          .value = std::get<std::string>(lexer.get_value())
+        make(ast::Identifier{
+          .location = tokens.last_location(),
+          .value = std::string(std::get<std::string_view>(tokens.get_value()))
         })
       );
 
-      if(lexer.peek_token() != Token::COLON) {
+      if(tokens.peek_token() != Token::COLON) {
         error("expected :");
         return nullptr;
       }
-      lexer.next_token();
-      lexer.next_token();
+      tokens.next_token();
+      tokens.next_token();
 
       values.push_back(expr(Precedence::LOWEST));
 
-      if(lexer.peek_token() == Token::RCURLY) {
+      if(tokens.peek_token() == Token::RCURLY) {
         break;
       }
 
-      if(lexer.peek_token() != Token::COMMA) {
+      if(tokens.peek_token() != Token::COMMA) {
         error("expected , or }");
         return nullptr;
       }
 
-      lexer.next_token();
+      tokens.next_token();
     }
   }
 
-  if(lexer.peek_token() != Token::RCURLY) {
+  if(tokens.peek_token() != Token::RCURLY) {
     error("expected }");
     return nullptr;
   }
 
-  lexer.next_token();
-  return std::make_unique<ast::Expr>(ast::Expr{
+  tokens.next_token();
+  return make(ast::Expr{
     .type = ExprType::STRUCTLIT,
     .child = ast::StructLit{
-      .name = std::move(name),
+      .name = name,
       .names = std::move(names),
       .value = std::move(values)
     }
@@ -906,79 +923,79 @@ Parser::struct_lit(ast::ExprRef name) {
 
 ast::ExprRef
 Parser::ident_expr() {
-  return std::make_unique<ast::Expr>(ast::Expr{
+  return make(ast::Expr{
     .type = ExprType::IDENTEXPR,
     .child = ast::Identifier{
-      .location = lexer.last_location(),
-      .value = std::get<std::string>(lexer.get_value())
+      .location = tokens.last_location(),
+      .value = std::string(std::get<std::string_view>(tokens.get_value()))
     }
   });
 }
 
 ast::ExprRef
 Parser::assignment_expr(ast::ExprRef left) {
-  const Location loc = lexer.last_location();
-  lexer.next_token();
+  const Location loc = tokens.last_location();
+  tokens.next_token();
 
   ast::ExprRef right = expr(Precedence::LOWEST);
   if(right == nullptr) {
     return nullptr;
   }
 
-  return std::make_unique<ast::Expr>(ast::Expr{
+  return make(ast::Expr{
     .type = ExprType::ASSIGNMENTEXP,
     .child = ast::AssignmentExpr{
       .location = loc,
-      .left = std::move(left),
-      .right = std::move(right)
+      .left = left,
+      .right = right
     }
   });
 }
 
 ast::ExprRef
 Parser::opassignment_expr(ast::ExprRef left) {
-  const Location loc = lexer.last_location();
-  Token operator_ = opassignment.at(lexer.last_token());
+  const Location loc = tokens.last_location();
+  Token operator_ = opassignment.at(tokens.last_token());
 
-  lexer.next_token();
+  tokens.next_token();
   ast::ExprRef right = expr(Precedence::LOWEST);
   if(right == nullptr) {
     return nullptr;
   }
 
-  return std::make_unique<ast::Expr>(ast::Expr{
+  return make(ast::Expr{
     .type = ast::OPASSIGNMENTEXP,
     .child = ast::OpAssignmentExpr{
       .location = loc,
       .operator_ = operator_,
-      .left = std::move(left),
-      .right = std::move(right)
+      .left = left,
+      .right = right
     }
   });
 }
 
 ast::ExprRef
 Parser::index_expr(ast::ExprRef left) {
-  const Location loc = lexer.location();
+  const Location loc = tokens.location();
 
-  lexer.next_token();
+  tokens.next_token();
   ast::ExprRef index = expr(Precedence::LOWEST);
   if(index == nullptr) {
     return nullptr;
   }
 
-  if(lexer.peek_token() != Token::RSQR) {
+  if(tokens.peek_token() != Token::RSQR) {
     error("expected ]");
     return nullptr;
   }
-  lexer.next_token();
+  tokens.next_token();
 
-  return std::make_unique<ast::Expr>(ast::Expr{
+  return make(ast::Expr{
     .type = ExprType::INDEXEXP,
     .child = ast::IndexExpr{
       .location = loc,
-      .left = std::move(left),
-      .index = std::move(index)
+      .left = left,
+      .index = index
     }
   });
 }
@@ -990,10 +1007,10 @@ Parser::call_expr(ast::ExprRef left) {
     return nullptr;
   }
 
-  return std::make_unique<ast::Expr>(ast::Expr{
+  return make(ast::Expr{
     .type = ast::CALLEXP,
     .child = ast::CallExpr{
-      .function = std::move(left),
+      .function = left,
       .arguments = std::move(*arguments)
     }
   });
@@ -1001,35 +1018,33 @@ Parser::call_expr(ast::ExprRef left) {
 
 ast::ExprRef
 Parser::member_expr(ast::ExprRef left) {
-  if(lexer.peek_token() != Token::IDENTIFIER) {
+  if(tokens.peek_token() != Token::IDENTIFIER) {
     error("expected identifier");
     return nullptr;
   }
 
-  lexer.next_token();
-  ast::IdentifierRef field = std::make_unique<ast::Identifier>(ast::Identifier{
-    .location = lexer.last_location(),
-    .value = std::get<std::string>(lexer.get_value())
+  tokens.next_token();
+  ast::IdentifierRef field = make(ast::Identifier{
+    .location = tokens.last_location(),
+    .value = std::string(std::get<std::string_view>(tokens.get_value()))
   });
 
-  return std::make_unique<ast::Expr>(ast::Expr{
+  return make(ast::Expr{
     .type = ExprType::MEMBEREXP,
     .child = ast::MemberExpr{
-      .left = std::move(left),
-      .field = std::move(field)
+      .left = left,
+      .field = field
     }
   });
 }
 
 Precedence
 Parser::peek_precedence() {
-  const Token& t = lexer.peek_token();
-  return precedences.contains(t) ? precedences.at(t) : Precedence::LOWEST;
+  return precedences[tokens.peek_token()];
 }
 
 Precedence
 Parser::current_precedence() {
-  const Token& t = lexer.last_token();
-  return precedences.contains(t) ? precedences.at(t) : Precedence::LOWEST;
+  return precedences[tokens.last_token()];
 }
 };
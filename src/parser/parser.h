@@ -9,8 +9,12 @@
 #ifndef __PARSER_H__
 #define __PARSER_H__
 
+#include <array>
+#include <cstddef>
+#include <map>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <token.h>
 #include <lexer.h>
 #include <ast.h>
@@ -75,9 +79,34 @@ private:
   Precedence peek_precedence();
   Precedence current_precedence();
 
-  Lexer &lexer;
+  // allocates a node in the arena of the program being parsed
+  template<typename T>
+  T* make(T&&);
+
+  using UnaryParseFn = ast::ExprRef (Parser::*)();
+  using BinaryParseFn = ast::ExprRef (Parser::*)(ast::ExprRef);
+
+  // prefix and infix parse functions indexed by token, null where a
+  // token cannot start or continue an expression
+  static const std::array<UnaryParseFn, token::__TOKENCOUNT__> unaryfns;
+  static const std::array<BinaryParseFn, token::__TOKENCOUNT__> binaryfns;
+
+  TokenStream tokens;
+  ast::ProgramRef program;
   std::vector<std::string> _errors;
+  // equal string literals share one constant
+  std::map<std::string, ast::Constant> constants;
 };
+
+// parses data cut at top level statements on up to jobs threads and
+// joins the pieces in source order. a source with an error is parsed
+// again in one piece by lexer so errors are the ones Parser reports
+ast::ProgramRef parse(
+  Lexer& lexer,
+  std::string_view data,
+  size_t jobs,
+  std::vector<std::string>& errors
+);
 };
 
 #endif
@@ -5,10 +5,12 @@
 #include <token.h>
 #include <print>
 #include <string>
+#include <vector>
 #include <iostream>
 #include <lexer.h>
 #include <ast.h>
 #include <parser.h>
+#include <resolver.h>
 #include <gc.h>
 #include <scope.h>
 
@@ -33,6 +35,8 @@ repl() {
   std::println("\e[32m{} {}\e[0m", HELPER, VERSION_STR);
   std::string line;
   Scope scope;
+  // functions keep pointing into the tree of the line that defined them
+  std::vector<ast::ProgramRef> programs;
 
   while(true) {
     std::print(PROMPT);
@@ -61,6 +65,15 @@ repl() {
           gc::collect();
           std::println("-----------------------");
           std::println("after cleanup:\n\tobjects: {}", gc::count());
+          std::println("-----------------------");
+          gc::Stats stats = gc::stats();
+          std::println(
+            "since start:\n\tallocs: {}\n\tfrees: {}\n\tcollections: {}\n\tpeak objects: {}",
+            stats.allocs,
+            stats.frees,
+            stats.collections,
+            stats.peak
+          );
           std::println("=======================");
           continue;
         }
@@ -90,8 +103,12 @@ repl() {
       std::println("{}", to_string(prgm));
     #endif
 
+    resolver::Resolver resolver;
+    resolver.resolve(prgm);
+
     Eval eval(lexer);
-    ObjectRef result = eval.evaluate(std::move(prgm), scope);
-    std::println("{}", result->value());
+    ObjectRef result = eval.evaluate(prgm, scope);
+    std::println("{}", result.value());
+    programs.push_back(std::move(prgm));
   }
 }
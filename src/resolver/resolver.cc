@@ -0,0 +1,299 @@
+#include <resolver.h>
+#include <ast.h>
+#include <utility>
+#include <variant>
+
+using ast::StmtType;
+using ast::ExprType;
+
+namespace resolver {
+Resolver::Resolver() {}
+
+void
+Resolver::resolve(const ast::ProgramRef& prgm) {
+  for(const auto& _stmt: prgm->stmts) {
+    stmt(*_stmt);
+  }
+}
+
+const std::vector<Location>&
+Resolver::tail_calls() const {
+  return tails;
+}
+
+void
+Resolver::stmt(ast::Stmt& _stmt) {
+  switch(_stmt.type) {
+    case StmtType::EXPRESSIONSTMT:
+      expr(*std::get<ast::ExprStmt>(_stmt.child).expr);
+      break;
+
+    case StmtType::LETSTMT: {
+      auto& let = std::get<ast::LetStmt>(_stmt.child);
+      // the value is evaluated before the name exists
+      expr(*let.value);
+      declare(*let.name);
+      break;
+    }
+
+    case StmtType::RETURNSTMT: {
+      auto& ret = std::get<ast::ReturnStmt>(_stmt.child);
+      if(ret.value != nullptr) {
+        expr(*ret.value);
+      }
+      break;
+    }
+
+    case StmtType::IFSTMT: {
+      auto& _if = std::get<ast::IfStmt>(_stmt.child);
+      expr(*_if.condition);
+
+      frames.push_back(Frame{.layout = &_if.layout, .visible = {}});
+      block_stmt(*_if.consequence);
+      if(_if.alternative != nullptr) {
+        frames.back().visible.clear();
+        block_stmt(*_if.alternative);
+      }
+      frames.pop_back();
+      break;
+    }
+
+    case StmtType::FORSTMT: {
+      auto& _for = std::get<ast::ForStmt>(_stmt.child);
+      frames.push_back(Frame{.layout = &_for.layout, .visible = {}});
+
+      if(_for.pre != nullptr) {
+        stmt(*_for.pre);
+      }
+
+      if(_for.condition != nullptr) {
+        expr(*_for.condition);
+      }
+
+      frames.push_back(Frame{.layout = &_for.body->layout, .visible = {}});
+      block_stmt(*_for.body);
+      frames.pop_back();
+
+      if(_for.post != nullptr) {
+        expr(*_for.post);
+      }
+
+      frames.pop_back();
+      break;
+    }
+
+    case StmtType::FUNCTIONSTMT: {
+      auto& func = std::get<ast::FunctionStmt>(_stmt.child);
+      func_stmt(func);
+      declare(*func.name);
+      break;
+    }
+
+    case StmtType::STRUCTSTMT:
+      declare(*std::get<ast::StructStmt>(_stmt.child).name);
+      break;
+
+    case StmtType::EXTERNSTMT: {
+      auto& ext = std::get<ast::ExternStmt>(_stmt.child);
+      reference(*ext.libname);
+      declare(*ext.funcname);
+      break;
+    }
+
+    default:
+      break;
+  }
+}
+
+void
+Resolver::block_stmt(ast::BlockStmt& _stmt) {
+  for(const auto& s: _stmt.stmts) {
+    stmt(*s);
+  }
+}
+
+void
+Resolver::func_stmt(ast::FunctionStmt& _stmt) {
+  std::vector<Frame> outer = std::move(frames);
+
+  frames.clear();
+  frames.push_back(Frame{.layout = &_stmt.body->layout, .visible = {}});
+  for(const auto& p: _stmt.parameters) {
+    declare(*p);
+  }
+
+  size_t before = declared;
+  block_stmt(*_stmt.body);
+  frames = std::move(outer);
+
+  // a frame holding nothing but the parameters can be rebound in place,
+  // a let or a nested function anywhere in the body would outlive the
+  // call it belongs to
+  if(declared == before) {
+    for(const auto& s: _stmt.body->stmts) {
+      tail_stmt(*s, _stmt.name->value);
+    }
+  }
+}
+
+void
+Resolver::tail_stmt(ast::Stmt& _stmt, const std::string& name) {
+  switch(_stmt.type) {
+    case StmtType::RETURNSTMT: {
+      auto& ret = std::get<ast::ReturnStmt>(_stmt.child);
+      if(ret.value == nullptr || ret.value->type != ExprType::CALLEXP) {
+        break;
+      }
+
+      const auto& call = std::get<ast::CallExpr>(ret.value->child);
+      if(call.function->type != ExprType::IDENTEXPR) {
+        break;
+      }
+
+      const auto& callee = std::get<ast::Identifier>(call.function->child);
+      if(callee.value == name) {
+        ret.tail = true;
+        tails.push_back(callee.location);
+      }
+      break;
+    }
+
+    case StmtType::IFSTMT: {
+      auto& _if = std::get<ast::IfStmt>(_stmt.child);
+      for(const auto& s: _if.consequence->stmts) {
+        tail_stmt(*s, name);
+      }
+
+      if(_if.alternative != nullptr) {
+        for(const auto& s: _if.alternative->stmts) {
+          tail_stmt(*s, name);
+        }
+      }
+      break;
+    }
+
+    case StmtType::FORSTMT:
+      for(const auto& s: std::get<ast::ForStmt>(_stmt.child).body->stmts) {
+        tail_stmt(*s, name);
+      }
+      break;
+
+    default:
+      break;
+  }
+}
+
+void
+Resolver::expr(ast::Expr& _expr) {
+  switch(_expr.type) {
+    case ExprType::IDENTEXPR:
+      reference(std::get<ast::Identifier>(_expr.child));
+      break;
+
+    case ExprType::ARRAYLIT:
+      for(const auto& e: std::get<ast::ArrayLit>(_expr.child).elements) {
+        expr(*e);
+      }
+      break;
+
+    case ExprType::STRUCTLIT: {
+      auto& s = std::get<ast::StructLit>(_expr.child);
+      expr(*s.name);
+      for(const auto& v: s.value) {
+        expr(*v);
+      }
+      break;
+    }
+
+    case ExprType::UNARYEXP:
+      expr(*std::get<ast::UnaryExpr>(_expr.child).right);
+      break;
+
+    case ExprType::BINARYEXP: {
+      auto& binary = std::get<ast::BinaryExpr>(_expr.child);
+      expr(*binary.left);
+      expr(*binary.right);
+      break;
+    }
+
+    case ExprType::ASSIGNMENTEXP: {
+      auto& assign = std::get<ast::AssignmentExpr>(_expr.child);
+      expr(*assign.left);
+      expr(*assign.right);
+      break;
+    }
+
+    case ExprType::OPASSIGNMENTEXP: {
+      auto& opassign = std::get<ast::OpAssignmentExpr>(_expr.child);
+      expr(*opassign.left);
+      expr(*opassign.right);
+      break;
+    }
+
+    case ExprType::CALLEXP: {
+      auto& call = std::get<ast::CallExpr>(_expr.child);
+      expr(*call.function);
+      for(const auto& arg: call.arguments) {
+        expr(*arg);
+      }
+      break;
+    }
+
+    case ExprType::INDEXEXP: {
+      auto& index = std::get<ast::IndexExpr>(_expr.child);
+      expr(*index.left);
+      expr(*index.index);
+      break;
+    }
+
+    case ExprType::MEMBEREXP:
+      expr(*std::get<ast::MemberExpr>(_expr.child).left);
+      break;
+
+    default:
+      break;
+  }
+}
+
+// declarations in the global scope stay name based, it is shared with
+// the repl and with every function called from the top level
+void
+Resolver::declare(ast::Identifier& ident) {
+  if(frames.empty()) {
+    return;
+  }
+
+  declared++;
+  Frame& frame = frames.back();
+  std::vector<std::string>& names = frame.layout->names;
+
+  uint32_t index = names.size();
+  for(uint32_t i = 0; i < names.size(); i++) {
+    if(names[i] == ident.value) {
+      index = i;
+      break;
+    }
+  }
+
+  if(index == names.size()) {
+    names.push_back(ident.value);
+  }
+
+  frame.visible[ident.value] = index;
+  ident.slot = ast::Slot{.depth = 0, .index = index};
+}
+
+void
+Resolver::reference(ast::Identifier& ident) {
+  for(size_t i = frames.size(); i-- > 0;) {
+    const auto& visible = frames[i].visible;
+    if(auto it = visible.find(ident.value); it != visible.end()) {
+      ident.slot = ast::Slot{
+        .depth = static_cast<int32_t>(frames.size() - 1 - i),
+        .index = it->second
+      };
+      return;
+    }
+  }
+}
+};
@@ -0,0 +1,49 @@
+/*
+**  Author: Aniket Biswas (xunicatt)
+**  Github: https://github.com/xunicatt
+**  Description: assigns scope slots to local variables after parsing
+**  File: resolver.h
+*/
+
+#ifndef __RESOLVER_H__
+#define __RESOLVER_H__
+
+#include <ast.h>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace resolver {
+// only names declared earlier in the same function (or top-level block)
+// are resolved, free variables are looked up by name at runtime since
+// a function sees the variables of its caller
+class Resolver {
+public:
+  Resolver();
+  void resolve(const ast::ProgramRef&);
+  // the self calls marked as tail calls, in source order
+  const std::vector<Location>& tail_calls() const;
+
+private:
+  struct Frame {
+    ast::Layout* layout;
+    std::map<std::string, uint32_t> visible;
+  };
+
+  void stmt(ast::Stmt&);
+  void block_stmt(ast::BlockStmt&);
+  void func_stmt(ast::FunctionStmt&);
+  void tail_stmt(ast::Stmt&, const std::string&);
+  void expr(ast::Expr&);
+
+  void declare(ast::Identifier&);
+  void reference(ast::Identifier&);
+
+  std::vector<Frame> frames;
+  // names declared inside functions so far
+  size_t declared = 0;
+  std::vector<Location> tails;
+};
+};
+
+#endif
@@ -1,3 +1,4 @@
+#include <ast.h>
 #include <object.h>
 #include <scope.h>
 #include <string>
@@ -9,60 +10,172 @@ namespace gc {
 }
 
 Scope::Scope() {
+  layout = nullptr;
   outer = nullptr;
 }
 
 Scope::Scope(Scope* _outer) {
+  layout = nullptr;
   outer = _outer;
 }
 
+Scope::Scope(Scope* _outer, const ast::Layout* _layout) {
+  layout = _layout;
+  outer = _outer;
+  if(layout != nullptr) {
+    slots.resize(layout->names.size());
+  }
+}
+
 bool
 Scope::exists(const std::string& name) const {
-  return table.contains(name);
+  return lookup(name) != nullptr;
 }
 
 bool
-Scope::exists_any(const std::string& name) const {
-  if(exists(name)) {
-    return true;
+Scope::exists(const ast::Slot& slot) const {
+  return static_cast<bool>(at(slot.depth)->slots[slot.index]);
+}
+
+bool
+Scope::exists(const ast::Identifier& ident) const {
+  if(ast::resolved(ident.slot)) {
+    return exists(ident.slot);
   }
 
-  if(outer != nullptr) {
-    return outer->exists_any(name);
+  return exists(ident.value);
+}
+
+bool
+Scope::exists_any(const std::string& name) const {
+  return static_cast<bool>(find(name));
+}
+
+ObjectRef
+Scope::find(const std::string& name) const {
+  for(const Scope* scp = this; scp != nullptr; scp = scp->outer) {
+    if(const ObjectRef* obj = scp->lookup(name); obj != nullptr) {
+      return *obj;
+    }
   }
 
-  return false;
+  return ObjectRef();
 }
 
+// an empty ref when the variable is not defined
 ObjectRef
-Scope::get(const std::string& name) const {
-  if(exists(name)) {
-    return table.at(name);
+Scope::find(const ast::Identifier& ident) const {
+  if(ast::resolved(ident.slot)) {
+    return get(ident.slot);
   }
 
-  if(outer != nullptr) {
-    return outer->get(name);
+  return find(ident.value);
+}
+
+ObjectRef
+Scope::get(const std::string& name) const {
+  if(ObjectRef obj = find(name); obj) {
+    return obj;
   }
 
   return OBJECT_NULL;
 }
 
+ObjectRef
+Scope::get(const ast::Slot& slot) const {
+  return at(slot.depth)->slots[slot.index];
+}
+
 ObjectRef
 Scope::set(const std::string& name, const ObjectRef& obj) {
+  if(layout != nullptr) {
+    for(size_t i = 0; i < layout->names.size(); i++) {
+      if(layout->names[i] == name) {
+        slots[i] = obj;
+        return obj;
+      }
+    }
+  }
+
   table[name] = obj;
   return obj;
 }
 
 ObjectRef
-Scope::update(const std::string& name, const ObjectRef& obj) {
-  if(exists(name)) {
-    table[name] = obj;
-    return obj;
+Scope::set(const ast::Slot& slot, const ObjectRef& obj) {
+  slots[slot.index] = obj;
+  return obj;
+}
+
+ObjectRef
+Scope::set(const ast::Identifier& ident, const ObjectRef& obj) {
+  if(ast::resolved(ident.slot)) {
+    return set(ident.slot, obj);
   }
 
-  if(outer) {
-    return outer->update(name, obj);
+  return set(ident.value, obj);
+}
+
+ObjectRef
+Scope::update(const std::string& name, const ObjectRef& obj) {
+  for(Scope* scp = this; scp != nullptr; scp = scp->outer) {
+    if(scp->lookup(name) != nullptr) {
+      return scp->set(name, obj);
+    }
   }
 
   return OBJECT_NULL;
 }
+
+ObjectRef
+Scope::update(const ast::Slot& slot, const ObjectRef& obj) {
+  at(slot.depth)->slots[slot.index] = obj;
+  return obj;
+}
+
+ObjectRef
+Scope::update(const ast::Identifier& ident, const ObjectRef& obj) {
+  if(ast::resolved(ident.slot)) {
+    return update(ident.slot, obj);
+  }
+
+  return update(ident.value, obj);
+}
+
+// a declared but not yet defined slot is invisible by name
+const ObjectRef*
+Scope::lookup(const std::string& name) const {
+  if(layout != nullptr) {
+    for(size_t i = 0; i < layout->names.size(); i++) {
+      if(layout->names[i] == name && slots[i]) {
+        return &slots[i];
+      }
+    }
+  }
+
+  if(auto it = table.find(name); it != table.end()) {
+    return &it->second;
+  }
+
+  return nullptr;
+}
+
+Scope*
+Scope::at(int32_t depth) {
+  Scope* scp = this;
+  while(depth-- > 0) {
+    scp = scp->outer;
+  }
+
+  return scp;
+}
+
+const Scope*
+Scope::at(int32_t depth) const {
+  const Scope* scp = this;
+  while(depth-- > 0) {
+    scp = scp->outer;
+  }
+
+  return scp;
+}
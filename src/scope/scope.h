@@ -1,4 +1,3 @@
-
 /*
 **  Author: Aniket Biswas (xunicatt)
 **  Github: https://github.com/xunicatt
@@ -10,23 +9,44 @@
 #ifndef __SCOPE_H__
 #define __SCOPE_H__
 
+#include <ast.h>
 #include <map>
 #include <object.h>
-#include <object.h>
 #include <string>
+#include <vector>
 
+// variables resolved by the resolver live in slots sized by the scope's
+// layout, every other variable (globals, repl) lives in the table.
+// slotted variables are still visible by name, scoping in eta is dynamic
+// and a called function looks up its free variables in the caller.
 class Scope {
 public:
   Scope();
   Scope(Scope*);
+  Scope(Scope*, const ast::Layout*);
   bool exists(const std::string&) const;
+  bool exists(const ast::Slot&) const;
+  bool exists(const ast::Identifier&) const;
   bool exists_any(const std::string&) const;
+  ObjectRef find(const std::string&) const;
+  ObjectRef find(const ast::Identifier&) const;
   ObjectRef get(const std::string&) const;
+  ObjectRef get(const ast::Slot&) const;
   ObjectRef set(const std::string&, const ObjectRef&);
+  ObjectRef set(const ast::Slot&, const ObjectRef&);
+  ObjectRef set(const ast::Identifier&, const ObjectRef&);
   ObjectRef update(const std::string&, const ObjectRef&);
+  ObjectRef update(const ast::Slot&, const ObjectRef&);
+  ObjectRef update(const ast::Identifier&, const ObjectRef&);
 
 private:
+  const ObjectRef* lookup(const std::string&) const;
+  Scope* at(int32_t);
+  const Scope* at(int32_t) const;
+
   std::map<std::string, ObjectRef> table;
+  std::vector<ObjectRef> slots;
+  const ast::Layout* layout;
   Scope* outer;
 };
 
@@ -0,0 +1,985 @@
+#include <vm.h>
+#include <bytecode.h>
+#include <eval.h>
+#include <gc.h>
+#include <object.h>
+#include <scope.h>
+#include <token.h>
+#include <dlfcn.h>
+#include <format>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using bytecode::OpCode;
+using token::Token;
+
+extern const ObjectRef OBJECT_NULL;
+extern const ObjectRef OBJECT_TRUE;
+extern const ObjectRef OBJECT_FALSE;
+extern const std::map<std::string, ObjectRef> builtinfns;
+
+namespace vm {
+// slot of field in the value, the name is only looked up when the
+// struct differs from the one the instruction saw last
+static size_t
+member_slot(bytecode::MemberCache& cache, const StructVal& sv, const std::string& field) {
+  const Struct& s = std::get<Struct>(sv.parent->child);
+  if(cache.shape != s.shape) {
+    size_t slot = s.slot(field);
+    if(slot == Struct::NONE) {
+      return slot;
+    }
+
+    cache.shape = s.shape;
+    cache.slot = slot;
+  }
+
+  return cache.slot;
+}
+
+VM::VM(Lexer& lexer, size_t max_stack)
+  :lexer(lexer), max_stack(max_stack) {
+  module = nullptr;
+  globals = nullptr;
+}
+
+ObjectRef
+VM::run(const bytecode::Module& _module, Scope& scp) {
+  module = &_module;
+  globals = &scp;
+  bindings.resize(module->symbols.size());
+  frames.reserve(256);
+  slots.reserve(1024);
+  frames.push_back(Frame{
+    .chunk = module->chunks.front().get(),
+    .pc = 0,
+    .base = 0,
+    .scopes = 0
+  });
+
+  ObjectRef result = execute();
+
+  stack.clear();
+  frames.clear();
+  handlers.clear();
+  while(!scopes.empty()) {
+    pop_scope();
+  }
+
+  return result;
+}
+
+ObjectRef
+VM::execute() {
+  ObjectRef err;
+
+  while(true) {
+    Frame& frame = frames.back();
+    const bytecode::Chunk& chunk = *frame.chunk;
+    const bytecode::Instr& in = chunk.code[frame.pc++];
+
+    switch(in.op) {
+      case OpCode::HALT:
+        return OBJECT_NULL;
+
+      case OpCode::POP:
+        stack.pop_back();
+        break;
+
+      case OpCode::CONST: {
+        const ObjectRef& obj = chunk.constants[in.a];
+        if(obj.type() != ObjectType::STRING) {
+          stack.push_back(obj);
+          break;
+        }
+
+        // strings are mutable, every evaluation gets its own object
+        // sharing the characters of the constant until it is written to
+        ObjectRef str = gc::alloc();
+        str->type = ObjectType::STRING;
+        str->child = std::get<String>(obj->child);
+        stack.push_back(str);
+        break;
+      }
+
+      case OpCode::NULL_:
+        stack.push_back(OBJECT_NULL);
+        break;
+
+      case OpCode::TRUE:
+        stack.push_back(OBJECT_TRUE);
+        break;
+
+      case OpCode::FALSE:
+        stack.push_back(OBJECT_FALSE);
+        break;
+
+      case OpCode::GET: {
+        const ast::Identifier& ident = chunk.variables[in.a];
+        if(ObjectRef obj = find(chunk, in.a); obj) {
+          stack.push_back(obj);
+          break;
+        }
+
+        if(builtinfns.contains(ident.value)) {
+          stack.push_back(builtinfns.at(ident.value));
+          break;
+        }
+
+        err = derr(chunk.locations[in.loc], "undefined identifier");
+        break;
+      }
+
+      case OpCode::LETCHECK: {
+        const ast::Identifier& ident = chunk.variables[in.a];
+        if(exists(chunk, in.a) || builtinfns.contains(ident.value)) {
+          err = derr(chunk.locations[in.loc], "redefinition of variable");
+        }
+        break;
+      }
+
+      case OpCode::LET:
+      case OpCode::SET:
+        set(chunk, in.a, pop());
+        break;
+
+      case OpCode::ASSIGNCHECK: {
+        ObjectRef obj = find(chunk, in.a);
+        if(!obj) {
+          err = derr(chunk.locations[in.loc], "undefined identifier");
+          break;
+        }
+
+        if(obj.type() == ObjectType::ELIB) {
+          err = derr(
+            chunk.locations[in.loc],
+            "a 'library' type variable cannot be reassigned"
+          );
+          break;
+        }
+
+        if(obj.type() == ObjectType::BFUNC ||
+          obj.type() == ObjectType::FUNC ||
+          obj.type() == ObjectType::EFUNC) {
+          err = derr(
+            chunk.locations[in.loc],
+            "a 'function' type variable cannot be reassigned"
+          );
+          break;
+        }
+
+        stack.push_back(obj);
+        break;
+      }
+
+      case OpCode::ASSIGN: {
+        ObjectRef value = pop();
+        ObjectRef obj = pop();
+
+        if(obj.type() != ObjectType::NULL_ && value.type() != obj.type()) {
+          err = derr(
+            chunk.locations[in.loc],
+            std::format(
+              "value of type '{}' cannot be assigned to a variable type of '{}'",
+              to_string(value.type()),
+              to_string(obj.type())
+            )
+          );
+          break;
+        }
+
+        stack.push_back(update(chunk, in.a, value));
+        break;
+      }
+
+      case OpCode::OPASSIGN: {
+        ObjectRef value = pop();
+        ObjectRef obj = find(chunk, in.a);
+
+        if(obj.type() != value.type()) {
+          err = derr(
+            chunk.locations[in.loc],
+            std::format(
+              "type mismatch between '{}' and '{}'",
+              to_string(obj.type()),
+              to_string(value.type())
+            )
+          );
+          break;
+        }
+
+        stack.push_back(update(chunk, in.a, value));
+        break;
+      }
+
+      case OpCode::UNARY: {
+        ObjectRef value = unary(static_cast<Token>(in.a), pop());
+        if(is_err(value)) {
+          err = derr(chunk.locations[in.loc], value);
+          break;
+        }
+
+        stack.push_back(value);
+        break;
+      }
+
+      case OpCode::BINARY: {
+        ObjectRef rvalue = pop();
+        ObjectRef lvalue = pop();
+        ObjectRef value = binary(static_cast<Token>(in.a), lvalue, rvalue);
+        if(is_err(value)) {
+          err = derr(chunk.locations[in.loc], value);
+          break;
+        }
+
+        stack.push_back(value);
+        break;
+      }
+
+      case OpCode::ARRAY: {
+        ObjectRef array = gc::alloc();
+        array->type = ObjectType::ARRAY;
+        array->child = Array(std::vector<ObjectRef>(stack.end() - in.a, stack.end()));
+
+        stack.resize(stack.size() - in.a);
+        stack.push_back(array);
+        break;
+      }
+
+      case OpCode::INDEX: {
+        ObjectRef idx = pop();
+        ObjectRef obj = pop();
+
+        if(idx.type() != ObjectType::INT) {
+          err = derr(chunk.locations[in.loc], "expected an 'int' type");
+          break;
+        }
+
+        int64_t i = idx.as_int();
+
+        if(obj.type() == ObjectType::STRING) {
+          const std::string& str = std::get<String>(obj->child).value();
+          if(i < 0 || i >= static_cast<int64_t>(str.length())) {
+            err = derr(chunk.locations[in.loc + 1], "index out of range");
+            break;
+          }
+
+          ObjectRef value = gc::alloc();
+          value->type = ObjectType::STRING;
+          value->child = String(std::string{str[i]});
+          stack.push_back(value);
+          break;
+        }
+
+        if(obj.type() == ObjectType::ARRAY) {
+          const Array& arr = std::get<Array>(obj->child);
+          if(i < 0 || i >= static_cast<int64_t>(arr.size())) {
+            err = derr(chunk.locations[in.loc + 1], "index out of range");
+            break;
+          }
+
+          stack.push_back(arr.at(i));
+          break;
+        }
+
+        err = derr(chunk.locations[in.loc + 2], "type cannot be indexed");
+        break;
+      }
+
+      case OpCode::INDEXCHECK: {
+        const ObjectRef& obj = stack.back();
+        if(obj.type() != ObjectType::ARRAY && obj.type() != ObjectType::STRING) {
+          err = derr(chunk.locations[in.loc], "type cannot be indexed");
+        }
+        break;
+      }
+
+      case OpCode::INDEXKEY: {
+        const ObjectRef& idx = stack.back();
+        const ObjectRef& obj = stack[stack.size() - 2];
+
+        if(idx.type() != ObjectType::INT) {
+          err = derr(chunk.locations[in.loc], "expected a 'int' type");
+          break;
+        }
+
+        int64_t i = idx.as_int();
+        int64_t size = obj.type() == ObjectType::ARRAY ?
+          std::get<Array>(obj->child).size() :
+          std::get<String>(obj->child).value().length();
+
+        if(i < 0 || i >= size) {
+          err = derr(chunk.locations[in.loc], "index out of range");
+        }
+        break;
+      }
+
+      case OpCode::INDEXSET:
+        err = index_set(chunk, in);
+        break;
+
+      case OpCode::MEMBER:
+      case OpCode::MEMBERCHECK: {
+        const ObjectRef& obj = stack.back();
+        if(obj.type() != ObjectType::STRUCTVAL) {
+          err = derr(chunk.locations[in.loc], "expected a 'struct' instance type");
+          break;
+        }
+
+        const StructVal& s = std::get<StructVal>(obj->child);
+        const std::string& field = chunk.names[in.a];
+        size_t slot = member_slot(chunk.caches[in.b], s, field);
+        if(slot == Struct::NONE) {
+          err = derr(
+            chunk.locations[in.loc + 1],
+            std::format(
+              "struct '{}' has no field named '{}'",
+              std::get<Struct>(s.parent->child).name,
+              field
+            )
+          );
+          break;
+        }
+
+        if(in.op == OpCode::MEMBER) {
+          ObjectRef value = s.fields[slot];
+          stack.back() = value;
+        }
+        break;
+      }
+
+      case OpCode::MEMBERSET: {
+        ObjectRef val = pop();
+        ObjectRef obj = pop();
+        StructVal& sv = std::get<StructVal>(obj->child);
+        // the right side may have run this member on another struct
+        size_t slot = member_slot(chunk.caches[in.b], sv, chunk.names[in.a]);
+
+        if(val.type() != sv.fields[slot].type()) {
+          err = derr(
+            chunk.locations[in.loc],
+            std::format(
+              "expected type '{}' but got '{}'",
+              to_string(sv.fields[slot].type()),
+              to_string(val.type())
+            )
+          );
+          break;
+        }
+
+        sv.fields[slot] = val;
+        stack.push_back(obj);
+        break;
+      }
+
+      case OpCode::STRUCTCHECK:
+        if(stack.back().type() != ObjectType::STRUCT) {
+          err = derr(chunk.locations[in.loc], "expected 'struct' type");
+        }
+        break;
+
+      case OpCode::FIELDCHECK: {
+        const Struct& s = std::get<Struct>(stack[stack.size() - 1 - in.b]->child);
+        const std::string& field = chunk.names[in.a];
+
+        if(s.slot(field) == Struct::NONE) {
+          err = derr(
+            chunk.locations[in.loc],
+            std::format(
+              "struct '{}' contains no field named '{}'",
+              s.name,
+              field
+            )
+          );
+        }
+        break;
+      }
+
+      case OpCode::FIELDTYPE: {
+        const Struct& s = std::get<Struct>(stack[stack.size() - 1 - in.b]->child);
+        const ObjectRef& val = stack.back();
+        const std::string& field = chunk.names[in.a];
+
+        std::string type_name = to_string(val.type());
+        if(val.type() == ObjectType::STRUCTVAL) {
+          type_name = std::get<Struct>(std::get<StructVal>(val->child).parent->child).name;
+        }
+
+        size_t slot = s.slot(field);
+        if(s.types[slot] != type_name) {
+          err = derr(
+            chunk.locations[in.loc],
+            std::format(
+              "expected type '{}' but got '{}'",
+              s.types[slot],
+              type_name
+            )
+          );
+        }
+        break;
+      }
+
+      case OpCode::STRUCTLIT:
+        err = struct_lit(chunk, in);
+        break;
+
+      case OpCode::PRECALL: {
+        const ObjectRef& obj = stack.back();
+
+        switch(obj.type()) {
+          case ObjectType::FUNC: {
+            const Func& f = std::get<Func>(obj->child);
+            if(f.chunk->parameters.size() != in.a) {
+              err = derr(
+                chunk.locations[in.loc],
+                std::format(
+                  "function takes {} arguments but {} were given",
+                  f.chunk->parameters.size(),
+                  in.a
+                )
+              );
+            }
+            break;
+          }
+
+          case ObjectType::BFUNC:
+            break;
+
+          case ObjectType::EFUNC:
+            if(ObjectRef res = efunc_arity(std::get<EFunc>(obj->child), in.a); is_err(res)) {
+              err = derr(chunk.locations[in.loc], res);
+            }
+            break;
+
+          default:
+            err = derr(chunk.locations[in.loc], "not a function");
+        }
+        break;
+      }
+
+      case OpCode::CALL: {
+        ObjectRef funcobj = stack[stack.size() - 1 - in.a];
+        err = call(funcobj, in.a, chunk, in.loc);
+        break;
+      }
+
+      case OpCode::TAILCALL: {
+        ObjectRef funcobj = stack[stack.size() - 1 - in.a];
+        // a call of the running function rebinds the parameters in the
+        // frame's own scope and starts it over, anything else is a CALL
+        // and the RETURN after it
+        if(funcobj.type() != ObjectType::FUNC || std::get<Func>(funcobj->child).chunk != &chunk) {
+          err = call(funcobj, in.a, chunk, in.loc);
+          break;
+        }
+
+        while(scopes.size() > frame.scopes + 1) {
+          pop_scope();
+        }
+
+        size_t base = scopes.back().base;
+        size_t first = stack.size() - in.a;
+        for(size_t i = 0; i < in.a; i++) {
+          slots[base + chunk.parameters[i].slot.index] = stack[first + i];
+        }
+
+        stack.resize(frame.base);
+        frame.pc = 0;
+        break;
+      }
+
+      case OpCode::RETURN: {
+        ObjectRef value = pop();
+        Frame callee = frames.back();
+        frames.pop_back();
+
+        while(scopes.size() > callee.scopes) {
+          pop_scope();
+        }
+
+        stack.resize(callee.base);
+        stack.push_back(value);
+        break;
+      }
+
+      case OpCode::TRY:
+        handlers.push_back(Handler{
+          .frames = frames.size(),
+          .scopes = scopes.size(),
+          .stack = stack.size(),
+          .pc = in.a
+        });
+        break;
+
+      case OpCode::ENDTRY:
+        handlers.pop_back();
+        break;
+
+      case OpCode::JUMP:
+        frame.pc = in.a;
+        break;
+
+      case OpCode::JUMPIFNOT: {
+        ObjectRef cond = pop();
+        if(cond.type() != ObjectType::BOOL) {
+          err = derr(chunk.locations[in.loc], "expected a boolean value");
+          break;
+        }
+
+        if(!cond.as_bool()) {
+          frame.pc = in.a;
+        }
+        break;
+      }
+
+      case OpCode::PUSHSCOPE:
+        push_scope(chunk.layouts[in.a]);
+        break;
+
+      case OpCode::POPSCOPE:
+        pop_scope();
+        break;
+
+      case OpCode::POPSCOPES:
+        for(uint32_t i = 0; i < in.a; i++) {
+          pop_scope();
+        }
+        break;
+
+      case OpCode::FUNC: {
+        ObjectRef func = gc::alloc();
+        func->type = ObjectType::FUNC;
+        func->child = Func{
+          .parameters = {},
+          .body = nullptr,
+          .chunk = module->chunks[in.a].get()
+        };
+        stack.push_back(func);
+        break;
+      }
+
+      case OpCode::STRUCT:
+        err = struct_stmt(chunk, in);
+        break;
+
+      case OpCode::EXTERN:
+        err = extern_stmt(chunk, in);
+        break;
+
+      case OpCode::ERROR:
+        err = derr(chunk.locations[in.loc], chunk.names[in.a]);
+        break;
+
+      default:
+        break;
+    }
+
+    if(err) {
+      if(!recover(err)) {
+        return err;
+      }
+      err = ObjectRef();
+    }
+  }
+}
+
+ObjectRef
+VM::call(
+  const ObjectRef& funcobj,
+  size_t argc,
+  const bytecode::Chunk& chunk,
+  uint32_t loc
+) {
+  size_t first = stack.size() - argc;
+
+  switch(funcobj.type()) {
+    case ObjectType::FUNC: {
+      // frames[0] runs the program itself
+      if(frames.size() > max_stack) {
+        return overflow(chunk, loc);
+      }
+
+      const bytecode::Chunk* callee = std::get<Func>(funcobj->child).chunk;
+      size_t depth = scopes.size();
+
+      // the arguments go straight into the parameters' slots, the
+      // frame itself is one more entry in the frame array
+      push_scope(callee->layout);
+      size_t base = scopes.back().base;
+      for(size_t i = 0; i < argc; i++) {
+        slots[base + callee->parameters[i].slot.index] = stack[first + i];
+      }
+
+      stack.resize(first - 1);
+      frames.push_back(Frame{
+        .chunk = callee,
+        .pc = 0,
+        .base = stack.size(),
+        .scopes = depth
+      });
+      return ObjectRef();
+    }
+
+    case ObjectType::BFUNC: {
+      std::vector<ObjectRef> args(stack.begin() + first, stack.end());
+      ObjectRef retval = std::get<BFunc>(funcobj->child).func(args);
+      if(is_err(retval)) {
+        return derr(chunk.locations[loc], retval);
+      }
+
+      stack.resize(first - 1);
+      stack.push_back(retval);
+      return ObjectRef();
+    }
+
+    case ObjectType::EFUNC: {
+      const EFunc& efunc = std::get<EFunc>(funcobj->child);
+      std::vector<ObjectRef> args(stack.begin() + first, stack.end());
+
+      for(size_t i = 0; i < argc; i++) {
+        if(ObjectRef res = efunc_arg(efunc, i, args[i]); is_err(res)) {
+          return derr(chunk.locations[loc + 1 + i], res);
+        }
+      }
+
+      ObjectRef retval = efunc_call(efunc, args);
+      if(is_err(retval)) {
+        return derr(chunk.locations[loc], retval);
+      }
+
+      stack.resize(first - 1);
+      stack.push_back(retval);
+      return ObjectRef();
+    }
+
+    default:
+      return derr(chunk.locations[loc], "not a function");
+  }
+}
+
+ObjectRef
+VM::struct_lit(const bytecode::Chunk& chunk, const bytecode::Instr& in) {
+  const std::vector<std::string>& shape = chunk.shapes[in.a];
+  size_t first = stack.size() - shape.size();
+  const ObjectRef& obj = stack[first - 1];
+  const Struct& struct_obj = std::get<Struct>(obj->child);
+
+  // FIELDCHECK made sure every name is a field of the struct
+  std::vector<ObjectRef> fields(struct_obj.fields.size());
+  for(size_t i = 0; i < shape.size(); i++) {
+    fields[struct_obj.slot(shape[i])] = stack[first + i];
+  }
+
+  std::vector<std::string> uninit_f;
+  for(size_t i = 0; i < fields.size(); i++) {
+    if(!fields[i]) {
+      uninit_f.push_back(struct_obj.fields[i]);
+    }
+  }
+
+  if(uninit_f.size() > 0) {
+    std::stringstream ss;
+    std::copy(
+      uninit_f.begin(),
+      uninit_f.end(),
+      std::ostream_iterator<std::string>(ss, ", ")
+    );
+
+    return derr(
+      chunk.locations[in.loc],
+      std::format(
+        "uninitialized fields: '{}'",
+        ss.str()
+      )
+    );
+  }
+
+  ObjectRef res = gc::alloc();
+  res->type = ObjectType::STRUCTVAL;
+  res->child = StructVal{
+    .parent = obj,
+    .fields = std::move(fields)
+  };
+
+  stack.resize(first - 1);
+  stack.push_back(res);
+  return ObjectRef();
+}
+
+ObjectRef
+VM::struct_stmt(const bytecode::Chunk& chunk, const bytecode::Instr& in) {
+  const bytecode::StructDef& def = chunk.structs[in.a];
+  const std::string& name = chunk.variables[def.name].value;
+  if(exists(chunk, def.name) || builtinfns.contains(name)) {
+    return derr(chunk.locations[in.loc], "redefinition of variable");
+  }
+
+  ObjectRef res = gc::alloc();
+  res->type = ObjectType::STRUCT;
+  res->child = Struct(name, def.fields);
+
+  set(chunk, def.name, res);
+  return ObjectRef();
+}
+
+ObjectRef
+VM::extern_stmt(const bytecode::Chunk& chunk, const bytecode::Instr& in) {
+  const bytecode::ExternDef& def = chunk.externs[in.a];
+  const Location& funcloc = chunk.locations[in.loc];
+  const Location& libloc = chunk.locations[in.loc + 1];
+
+  if(exists(chunk, def.funcname)) {
+    return derr(funcloc, "redefinition of variable");
+  }
+
+  ObjectRef libobj = find(chunk, def.libname);
+  if(!libobj) {
+    return derr(libloc, "undefined identifier");
+  }
+
+  if(libobj.type() != ObjectType::ELIB) {
+    return derr(
+      libloc,
+      std::format(
+        "expected a 'external libary' type but got '{}' type",
+        to_string(libobj.type())
+      )
+    );
+  }
+
+  const ELib& lib = std::get<ELib>(libobj->child);
+  void* func = dlsym(lib.lib, chunk.variables[def.funcname].value.c_str());
+  if(char* err = dlerror(); err != nullptr) {
+    return derr(
+      funcloc,
+      std::format(
+        "failed to get external function: {}",
+        err
+      )
+    );
+  }
+
+  ObjectRef res = gc::alloc();
+  res->type = ObjectType::EFUNC;
+  res->child = EFunc{
+    .func = func,
+    .argstypes = def.argtypes,
+    .rettype = def.rettype
+  };
+
+  set(chunk, def.funcname, res);
+  return ObjectRef();
+}
+
+ObjectRef
+VM::index_set(const bytecode::Chunk& chunk, const bytecode::Instr& in) {
+  ObjectRef value = pop();
+  ObjectRef idx = pop();
+  ObjectRef obj = pop();
+  int64_t i = idx.as_int();
+
+  if(obj.type() == ObjectType::ARRAY) {
+    std::get<Array>(obj->child).set(i, value);
+    stack.push_back(obj);
+    return ObjectRef();
+  }
+
+  if(value.type() != ObjectType::STRING) {
+    return derr(
+      chunk.locations[in.loc],
+      std::format("type '{}' cannot be assigned to a string", to_string(value.type()))
+    );
+  }
+
+  if(std::get<String>(value->child).value().length() != 1) {
+    return derr(
+      chunk.locations[in.loc],
+      "expected a string with length of '1'"
+    );
+  }
+
+  std::get<String>(obj->child).mutable_value()[i] = std::get<String>(value->child).value()[0];
+  stack.push_back(obj);
+  return ObjectRef();
+}
+
+// eta scopes are dynamic, a name not resolved to a slot is the
+// innermost defined variable of that name in any running scope and
+// then the global one. the resolver gives every variable declared
+// inside a scope a slot, so only globals are declared by name
+ObjectRef
+VM::find(const bytecode::Chunk& chunk, uint32_t var) {
+  const ast::Identifier& ident = chunk.variables[var];
+  if(ast::resolved(ident.slot)) {
+    return slots[slot(ident.slot)];
+  }
+
+  if(ObjectRef* obj = lookup(chunk.symbols[var]); obj != nullptr) {
+    return *obj;
+  }
+
+  return globals->find(ident.value);
+}
+
+// only the innermost scope counts
+bool
+VM::exists(const bytecode::Chunk& chunk, uint32_t var) {
+  const ast::Identifier& ident = chunk.variables[var];
+  if(ast::resolved(ident.slot)) {
+    return static_cast<bool>(slots[slot(ident.slot)]);
+  }
+
+  if(scopes.empty()) {
+    return globals->exists(ident.value);
+  }
+
+  const std::vector<size_t>& bound = bindings[chunk.symbols[var]];
+  return !bound.empty() && bound.back() >= scopes.back().base && slots[bound.back()];
+}
+
+void
+VM::set(const bytecode::Chunk& chunk, uint32_t var, const ObjectRef& obj) {
+  const ast::Identifier& ident = chunk.variables[var];
+  if(ast::resolved(ident.slot)) {
+    slots[slot(ident.slot)] = obj;
+    return;
+  }
+
+  if(!scopes.empty()) {
+    const std::vector<size_t>& bound = bindings[chunk.symbols[var]];
+    if(!bound.empty() && bound.back() >= scopes.back().base) {
+      slots[bound.back()] = obj;
+      return;
+    }
+  }
+
+  globals->set(ident.value, obj);
+}
+
+ObjectRef
+VM::update(const bytecode::Chunk& chunk, uint32_t var, const ObjectRef& obj) {
+  const ast::Identifier& ident = chunk.variables[var];
+  if(ast::resolved(ident.slot)) {
+    slots[slot(ident.slot)] = obj;
+    return obj;
+  }
+
+  if(ObjectRef* old = lookup(chunk.symbols[var]); old != nullptr) {
+    *old = obj;
+    return obj;
+  }
+
+  return globals->update(ident.value, obj);
+}
+
+size_t
+VM::slot(const ast::Slot& s) const {
+  return scopes[scopes.size() - 1 - s.depth].base + s.index;
+}
+
+// a declared but not yet defined variable is skipped, as in Scope
+ObjectRef*
+VM::lookup(uint32_t symbol) {
+  const std::vector<size_t>& bound = bindings[symbol];
+  for(size_t i = bound.size(); i-- > 0;) {
+    if(slots[bound[i]]) {
+      return &slots[bound[i]];
+    }
+  }
+
+  return nullptr;
+}
+
+void
+VM::push_scope(const bytecode::Layout& layout) {
+  size_t base = slots.size();
+  slots.resize(base + layout.size());
+  for(size_t i = 0; i < layout.size(); i++) {
+    bindings[layout[i]].push_back(base + i);
+  }
+
+  scopes.push_back(Window{.layout = &layout, .base = base});
+}
+
+void
+VM::pop_scope() {
+  const Window& window = scopes.back();
+  for(uint32_t symbol: *window.layout) {
+    bindings[symbol].pop_back();
+  }
+
+  slots.resize(window.base);
+  scopes.pop_back();
+}
+
+// unwinds to the innermost guarded expression and hands it the error
+// every frame but the innermost is stopped right after the call that
+// made the next one
+ObjectRef
+VM::overflow(const bytecode::Chunk& chunk, uint32_t loc) {
+  std::vector<Location> calls;
+  calls.reserve(frames.size() - 1);
+  for(size_t i = 0; i + 1 < frames.size(); i++) {
+    const bytecode::Chunk& caller = *frames[i].chunk;
+    calls.push_back(caller.locations[caller.code[frames[i].pc - 1].loc]);
+  }
+
+  return ::overflow(lexer, chunk.locations[loc], calls);
+}
+
+bool
+VM::recover(const ObjectRef& err) {
+  if(handlers.empty()) {
+    return false;
+  }
+
+  Handler handler = handlers.back();
+  handlers.pop_back();
+
+  frames.resize(handler.frames);
+  while(scopes.size() > handler.scopes) {
+    pop_scope();
+  }
+
+  stack.resize(handler.stack);
+  stack.push_back(err);
+  frames.back().pc = handler.pc;
+  return true;
+}
+
+ObjectRef
+VM::pop() {
+  ObjectRef obj = stack.back();
+  stack.pop_back();
+  return obj;
+}
+
+bool
+VM::is_err(const ObjectRef& obj) {
+  return (obj) && (obj.type() == SERR || obj.type() == DERR);
+}
+
+ObjectRef
+VM::derr(const Location& loc, const ObjectRef& obj) {
+  if(!is_err(obj)) {
+    return obj;
+  }
+
+  if(obj.type() == ObjectType::DERR) {
+    return obj;
+  }
+
+  return derr(loc, std::get<String>(obj->child).value());
+}
+
+ObjectRef
+VM::derr(const Location& loc, const std::string& err_msg) {
+  ObjectRef err = gc::alloc();
+  err->type = ObjectType::DERR;
+  err->child = String(lexer.fmt_error(loc, err_msg));
+  return err;
+}
+};
@@ -0,0 +1,96 @@
+/*
+**  Author: Aniket Biswas (xunicatt)
+**  Github: https://github.com/xunicatt
+**  Description: stack based virtual machine to run compiled eta programs
+**  File: vm.h
+*/
+
+#ifndef __VM_H__
+#define __VM_H__
+
+#include <ast.h>
+#include <bytecode.h>
+#include <cstddef>
+#include <lexer.h>
+#include <object.h>
+#include <scope.h>
+#include <string>
+#include <vector>
+
+namespace vm {
+// calls the vm nests before it fails with a stack overflow. calls only
+// take an entry in the frame array and their variables' slots, so this
+// is far above what the tree walker fits on a default native stack
+constexpr size_t MAX_STACK = 100000;
+
+class VM {
+public:
+  VM(Lexer&, size_t max_stack = MAX_STACK);
+  ObjectRef run(const bytecode::Module&, Scope&);
+
+private:
+  struct Frame {
+    const bytecode::Chunk* chunk;
+    size_t pc;
+    size_t base;
+    size_t scopes;
+  };
+
+  // a running scope, its variables are the slots from base on
+  struct Window {
+    const bytecode::Layout* layout;
+    size_t base;
+  };
+
+  struct Handler {
+    size_t frames;
+    size_t scopes;
+    size_t stack;
+    size_t pc;
+  };
+
+  ObjectRef execute();
+  ObjectRef call(const ObjectRef&, size_t, const bytecode::Chunk&, uint32_t);
+  ObjectRef overflow(const bytecode::Chunk&, uint32_t);
+  ObjectRef struct_lit(const bytecode::Chunk&, const bytecode::Instr&);
+  ObjectRef struct_stmt(const bytecode::Chunk&, const bytecode::Instr&);
+  ObjectRef extern_stmt(const bytecode::Chunk&, const bytecode::Instr&);
+  ObjectRef index_set(const bytecode::Chunk&, const bytecode::Instr&);
+
+  // variables by their index in a chunk's variables
+  ObjectRef find(const bytecode::Chunk&, uint32_t);
+  bool exists(const bytecode::Chunk&, uint32_t);
+  void set(const bytecode::Chunk&, uint32_t, const ObjectRef&);
+  ObjectRef update(const bytecode::Chunk&, uint32_t, const ObjectRef&);
+  size_t slot(const ast::Slot&) const;
+  ObjectRef* lookup(uint32_t);
+
+  void push_scope(const bytecode::Layout&);
+  void pop_scope();
+  bool recover(const ObjectRef&);
+  ObjectRef pop();
+
+  bool is_err(const ObjectRef&);
+  ObjectRef derr(const Location&, const ObjectRef&);
+  ObjectRef derr(const Location&, const std::string&);
+
+  Lexer& lexer;
+  const bytecode::Module* module;
+  std::vector<ObjectRef> stack;
+  std::vector<Frame> frames;
+  std::vector<Handler> handlers;
+  // the variables of every running scope live in one array, innermost
+  // last, and keep its capacity from call to call
+  std::vector<ObjectRef> slots;
+  std::vector<Window> scopes;
+  // for each symbol the slots of the running scopes that declare it,
+  // innermost last. a name is looked up here instead of through the
+  // scopes of every running call
+  std::vector<std::vector<size_t>> bindings;
+  // the program's own scope, holding the names declared at the top level
+  Scope* globals;
+  size_t max_stack;
+};
+};
+
+#endif